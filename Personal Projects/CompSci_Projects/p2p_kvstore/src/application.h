@@ -26,6 +26,16 @@ public:
     /** Getter for the current node index. */
     size_t this_node() { return idx_; }
 
+    /** Prints how much memory each part of every node uses, asking the other nodes for theirs. */
+    void print_memory() {
+        KVStore* kv = kd_.get_kv();
+        for (size_t i = 0; i < kv->num_nodes(); i++) {
+            MemoryUsage* usage = kv->memory_usage(i);
+            usage->print(i);
+            delete usage;
+        }
+    }
+
     /** Called when the application has finished its execution. */
     void done() { kd_.done(); }
 };
\ No newline at end of file
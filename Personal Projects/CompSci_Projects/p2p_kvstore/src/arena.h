@@ -0,0 +1,127 @@
+//lang::Cpp
+
+#pragma once
+
+#include <string.h>
+#include <vector>
+
+#include "object.h"
+
+// The size in bytes of each block that an Arena allocates from
+#define ARENA_BLOCK_SIZE 16384
+
+/**
+ * A bump allocator for short-lived memory, such as the pieces of a message being serialized or
+ * the scratch space of a Deserializer. Allocating moves a pointer forward in a block of memory,
+ * and everything allocated since a mark() is given back at once by rewind()ing to it. Nothing is
+ * freed individually, and the blocks are kept and reused until the Arena is deleted.
+ *
+ * Each thread has an Arena of its own, local(), which is normally used through an ArenaScope. An
+ * Arena must only be used by one thread.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Arena : public Object {
+public:
+    /** A position in an Arena to rewind to. */
+    struct Mark {
+        size_t block_;
+        size_t used_;
+    };
+
+    // The blocks, owned. Those after block_ are free and will be reused.
+    std::vector<char*> blocks_;
+    // The size of each block, most are ARENA_BLOCK_SIZE but larger allocations get larger ones
+    std::vector<size_t> sizes_;
+    // The index of the block currently allocated from
+    size_t block_;
+    // The number of bytes used in the current block
+    size_t used_;
+
+    Arena() : block_(0), used_(0) {
+        blocks_.push_back(new char[ARENA_BLOCK_SIZE]);
+        sizes_.push_back(ARENA_BLOCK_SIZE);
+    }
+
+    ~Arena() {
+        for (char* b : blocks_) delete[] b;
+    }
+
+    /** Returns the Arena of the calling thread. */
+    static Arena& local() {
+        static thread_local Arena arena;
+        return arena;
+    }
+
+    /** Returns n bytes of memory, aligned for any type, that stay valid until this Arena is
+     *  rewound to a mark taken before this call. */
+    char* alloc(size_t n) {
+        size_t start = (used_ + 7) & ~(size_t)7;
+        if (start + n > sizes_[block_]) {
+            // Move on to the next block, replacing it if it is too small
+            block_++;
+            start = 0;
+            size_t size = n > ARENA_BLOCK_SIZE ? n : ARENA_BLOCK_SIZE;
+            if (block_ == blocks_.size()) {
+                blocks_.push_back(new char[size]);
+                sizes_.push_back(size);
+            } else if (sizes_[block_] < n) {
+                delete[] blocks_[block_];
+                blocks_[block_] = new char[size];
+                sizes_[block_] = size;
+            }
+        }
+        used_ = start + n;
+        return blocks_[block_] + start;
+    }
+
+    /** Returns a copy of the given null terminated string allocated in this Arena. */
+    char* copy(const char* s) {
+        size_t len = strlen(s);
+        char* res = alloc(len + 1);
+        memcpy(res, s, len + 1);
+        return res;
+    }
+
+    /** Returns the current position of this Arena. */
+    Mark mark() { return Mark{block_, used_}; }
+
+    /** Gives back everything allocated since the given mark was taken. */
+    void rewind(Mark m) {
+        block_ = m.block_;
+        used_ = m.used_;
+    }
+
+    /** Returns the total number of bytes in this Arena's blocks. */
+    size_t capacity() {
+        size_t res = 0;
+        for (size_t s : sizes_) res += s;
+        return res;
+    }
+};
+
+/**
+ * Marks the calling thread's Arena when it is created and rewinds it when it is deleted, so that
+ * everything allocated through it in a block of code is freed at the end of the block. Scopes
+ * nest: only allocate through the innermost live one, or an inner scope will free memory that an
+ * outer one still uses.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class ArenaScope : public Object {
+public:
+    Arena& arena_;
+    Arena::Mark mark_;
+
+    ArenaScope() : arena_(Arena::local()), mark_(arena_.mark()) { }
+
+    ~ArenaScope() { arena_.rewind(mark_); }
+
+    /** Returns the Arena that this scope allocates from. */
+    Arena& arena() { return arena_; }
+
+    /** Returns n bytes that stay valid until this scope ends. */
+    char* alloc(size_t n) { return arena_.alloc(n); }
+};
@@ -0,0 +1,48 @@
+//lang::Cpp
+
+#pragma once
+
+#include <atomic>
+
+#include "object.h"
+
+/**
+ * An immutable, reference counted buffer of serialized data. Values are never changed once they
+ * are put into a KVStore, so a local read can share the stored buffer instead of copying it.
+ * Every holder of a Blob owns one reference: retain() adds one and release() gives one up, and
+ * the Blob deletes itself when the last one is released. Do not delete a Blob directly.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Blob : public Object {
+public:
+    // The data, null terminated, owned
+    char* data_;
+    // The number of bytes of data, not counting the terminator
+    size_t size_;
+    std::atomic<size_t> refs_;
+
+    /** Takes ownership of the given null terminated data of the given size. The new Blob has one
+     *  reference, which belongs to the caller. */
+    Blob(char* data, size_t size) : data_(data), size_(size), refs_(1) { }
+
+    ~Blob() { delete[] data_; }
+
+    /** Returns the data, which is valid for as long as the caller holds a reference. */
+    const char* data() { return data_; }
+
+    /** Returns the number of bytes of data. */
+    size_t size() { return size_; }
+
+    /** Adds a reference and returns this Blob. */
+    Blob* retain() {
+        refs_++;
+        return this;
+    }
+
+    /** Gives up a reference, deleting this Blob if it was the last one. */
+    void release() {
+        if (--refs_ == 0) delete this;
+    }
+};
@@ -0,0 +1,271 @@
+//lang::Cpp
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "serial.h"
+#include "hashmap.h"
+
+/** How the values of a Chunk in the binary format are encoded. The codec is stored in the third
+ *  byte of the chunk's header, so each chunk says how to read it. */
+enum class ChunkCodec { Raw = 0, FrameOfRef = 1, DeltaVarint = 2, Dictionary = 3 };
+
+/**
+ * The codecs that shrink the values of a Chunk before it is stored and sent. Every codec is exact,
+ * and a chunk is written with whichever of the codecs for its type makes it smallest:
+ *  - Raw: the values as described in Chunk, for every type. Bools are always a bitmap and floats
+ *    are always raw.
+ *  - FrameOfRef, for ints: the smallest value and the number of bits w of the largest difference
+ *    from it, as 32-bit integers, then the difference of every value from the smallest packed
+ *    into w bits each. Good for ints in a narrow range, such as the ids of a few thousand users.
+ *  - DeltaVarint, for ints: the difference of every value from the one before it, the first from
+ *    0, zigzag encoded so that small negative differences are small numbers too and written 7 bits
+ *    per byte, with the high bit set in every byte of a number but its last. Padded to a multiple
+ *    of 4 bytes. Good for sorted or dense ids, whose differences take a byte each.
+ *  - Dictionary, for strings: the number d of different strings and the number of bits w of an
+ *    index into them, as 32-bit integers; the index of the string of every field packed into w
+ *    bits each; the offsets of the different strings, d + 1 32-bit integers; then the different
+ *    strings back to back. Good for columns of a few repeated words.
+ * Packed bits are little-endian and padded to a multiple of 4 bytes. The values of missing fields
+ * are whatever encodes smallest, since they are never read: the value before them for ints and
+ * the first string for strings.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Codec : public Object {
+public:
+    /** Returns the number of bits needed to hold every number up to max. */
+    static size_t bits_for_(uint32_t max) {
+        size_t res = 0;
+        while (res < 32 && (max >> res) != 0) res++;
+        return res;
+    }
+
+    /** Returns the number of bytes of n numbers packed into width bits each. */
+    static size_t packed_bytes_(size_t n, size_t width) { return (n * width + 31) / 32 * 4; }
+
+    /** Packs v into the ith number of width bits at out, which must have been zeroed. */
+    static void pack_(char* out, size_t i, size_t width, uint32_t v) {
+        uint64_t bit = (uint64_t)i * width;
+        size_t shift = bit % 8;
+        uint64_t x = (uint64_t)v << shift;
+        char* dst = out + bit / 8;
+        for (size_t b = 0; 8 * b < shift + width; b++) dst[b] |= (char)(x >> (8 * b));
+    }
+
+    /** Returns the ith number of width bits packed at in. */
+    static uint32_t unpack_(const char* in, size_t i, size_t width) {
+        if (width == 0) return 0;
+        uint64_t bit = (uint64_t)i * width;
+        size_t shift = bit % 8;
+        const char* src = in + bit / 8;
+        uint64_t x = 0;
+        for (size_t b = 0; 8 * b < shift + width; b++) x |= (uint64_t)(uint8_t)src[b] << (8 * b);
+        return (uint32_t)((x >> shift) & (((uint64_t)1 << width) - 1));
+    }
+
+    /** Returns the zigzag encoding of the difference between v and prev. */
+    static uint64_t zigzag_(int v, int prev) {
+        int64_t d = (int64_t)v - prev;
+        return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+    }
+
+    /** Returns the number of bytes of z written 7 bits per byte. */
+    static size_t varint_bytes_(uint64_t z) {
+        size_t res = 1;
+        while (z >= 0x80) {
+            z >>= 7;
+            res++;
+        }
+        return res;
+    }
+
+    /** Returns the smallest and the largest of the n given ints, n > 0. */
+    static void range_(const int* vals, size_t n, int& lo, int& hi) {
+        lo = hi = vals[0];
+        for (size_t i = 1; i < n; i++) {
+            if (vals[i] < lo) lo = vals[i];
+            if (vals[i] > hi) hi = vals[i];
+        }
+    }
+
+    /** Returns the number of bytes that the n given ints take in the given codec. */
+    static size_t int_bytes(ChunkCodec codec, const int* vals, size_t n) {
+        switch (codec) {
+            case ChunkCodec::FrameOfRef: {
+                if (n == 0) return 8;
+                int lo, hi;
+                range_(vals, n, lo, hi);
+                return 8 + packed_bytes_(n, bits_for_((uint32_t)((int64_t)hi - lo)));
+            }
+            case ChunkCodec::DeltaVarint: {
+                size_t res = 0;
+                int prev = 0;
+                for (size_t i = 0; i < n; i++) {
+                    res += varint_bytes_(zigzag_(vals[i], prev));
+                    prev = vals[i];
+                }
+                return (res + 3) / 4 * 4;
+            }
+            default:
+                return 4 * n;
+        }
+    }
+
+    /** Returns the codec that encodes the n given ints in the fewest bytes, and stores that
+     *  number of bytes in len. */
+    static ChunkCodec best_int_codec(const int* vals, size_t n, size_t& len) {
+        ChunkCodec res = ChunkCodec::Raw;
+        len = int_bytes(res, vals, n);
+        for (ChunkCodec c : { ChunkCodec::FrameOfRef, ChunkCodec::DeltaVarint }) {
+            size_t bytes = int_bytes(c, vals, n);
+            if (bytes < len) {
+                res = c;
+                len = bytes;
+            }
+        }
+        return res;
+    }
+
+    /** Writes the n given ints in the given codec to out, which must have been zeroed and hold
+     *  int_bytes() bytes. */
+    static void encode_ints(ChunkCodec codec, const int* vals, size_t n, char* out) {
+        switch (codec) {
+            case ChunkCodec::FrameOfRef: {
+                if (n == 0) return;
+                int lo, hi;
+                range_(vals, n, lo, hi);
+                size_t width = bits_for_((uint32_t)((int64_t)hi - lo));
+                Serializer::put_u32(out, (uint32_t)lo);
+                Serializer::put_u32(out + 4, (uint32_t)width);
+                for (size_t i = 0; i < n; i++) {
+                    pack_(out + 8, i, width, (uint32_t)((int64_t)vals[i] - lo));
+                }
+                break;
+            }
+            case ChunkCodec::DeltaVarint: {
+                int prev = 0;
+                for (size_t i = 0; i < n; i++) {
+                    uint64_t z = zigzag_(vals[i], prev);
+                    while (z >= 0x80) {
+                        *out++ = (char)(z | 0x80);
+                        z >>= 7;
+                    }
+                    *out++ = (char)z;
+                    prev = vals[i];
+                }
+                break;
+            }
+            default:
+                for (size_t i = 0; i < n; i++) Serializer::put_u32(out + 4 * i, (uint32_t)vals[i]);
+        }
+    }
+
+    /** Reads n ints in the given codec from in, which holds len bytes, into out, and returns the
+     *  number of bytes they took. */
+    static size_t decode_ints(ChunkCodec codec, const char* in, size_t len, size_t n, int* out) {
+        Sys sys;
+        switch (codec) {
+            case ChunkCodec::FrameOfRef: {
+                sys.exit_if_not(len >= 8, "Chunk is truncated");
+                int lo = (int)Serializer::get_u32(in);
+                size_t width = Serializer::get_u32(in + 4);
+                sys.exit_if_not(width <= 32, "Chunk has a bad bit width");
+                size_t bytes = n == 0 ? 8 : 8 + packed_bytes_(n, width);
+                sys.exit_if_not(bytes <= len, "Chunk is truncated");
+                for (size_t i = 0; i < n; i++) {
+                    out[i] = (int)(uint32_t)((uint64_t)(uint32_t)lo + unpack_(in + 8, i, width));
+                }
+                return bytes;
+            }
+            case ChunkCodec::DeltaVarint: {
+                size_t at = 0;
+                int prev = 0;
+                for (size_t i = 0; i < n; i++) {
+                    uint64_t z = 0;
+                    for (size_t shift = 0;; shift += 7) {
+                        sys.exit_if_not(at < len && shift < 64, "Chunk is truncated");
+                        uint8_t b = (uint8_t)in[at++];
+                        z |= (uint64_t)(b & 0x7f) << shift;
+                        if (b < 0x80) break;
+                    }
+                    int64_t d = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+                    prev = out[i] = (int)(prev + d);
+                }
+                at = (at + 3) / 4 * 4;
+                sys.exit_if_not(at <= len, "Chunk is truncated");
+                return at;
+            }
+            default:
+                sys.exit_if_not(4 * n <= len, "Chunk is truncated");
+                for (size_t i = 0; i < n; i++) out[i] = (int)Serializer::get_u32(in + 4 * i);
+                return 4 * n;
+        }
+    }
+};
+
+/**
+ * The different strings of the string fields of a Chunk, for writing them with the Dictionary
+ * codec. Each different string gets the next index the first time it is seen.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class StrDict : public Object {
+public:
+    // The index of every different string
+    HashMap<String, uint32_t> ids_;
+    // The different strings in the order of their indices, external
+    std::vector<String*> strings_;
+    // The index of the string of each field
+    std::vector<uint32_t> idx_;
+    // The total number of bytes of the different strings
+    size_t bytes_;
+
+    /** Builds the dictionary of the n given strings, where nullptr is a missing field. */
+    StrDict(String** strs, size_t n) : bytes_(0) {
+        idx_.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            if (strs[i] == nullptr) continue;
+            uint32_t* found = ids_.find(*strs[i]);
+            if (found != nullptr) {
+                idx_[i] = *found;
+                continue;
+            }
+            idx_[i] = (uint32_t)strings_.size();
+            ids_.put(*strs[i], idx_[i]);
+            strings_.push_back(strs[i]);
+            bytes_ += strs[i]->size();
+        }
+    }
+
+    /** Returns the number of bits of an index. */
+    size_t width() { return Codec::bits_for_(strings_.empty() ? 0 : strings_.size() - 1); }
+
+    /** Returns the number of bytes of the strings written with the Dictionary codec. */
+    size_t encoded_bytes() {
+        return 8 + Codec::packed_bytes_(idx_.size(), width()) + 4 * (strings_.size() + 1) + bytes_;
+    }
+
+    /** Writes the strings with the Dictionary codec to out, which must have been zeroed and hold
+     *  encoded_bytes() bytes. */
+    void encode(char* out) {
+        size_t w = width();
+        Serializer::put_u32(out, (uint32_t)strings_.size());
+        Serializer::put_u32(out + 4, (uint32_t)w);
+        char* packed = out + 8;
+        for (size_t i = 0; i < idx_.size(); i++) Codec::pack_(packed, i, w, idx_[i]);
+        char* offsets = packed + Codec::packed_bytes_(idx_.size(), w);
+        char* strs = offsets + 4 * (strings_.size() + 1);
+        uint32_t off = 0;
+        for (size_t i = 0; i < strings_.size(); i++) {
+            Serializer::put_u32(offsets + 4 * i, off);
+            memcpy(strs + off, strings_[i]->c_str(), strings_[i]->size());
+            off += strings_[i]->size();
+        }
+        Serializer::put_u32(offsets + 4 * strings_.size(), off);
+    }
+};
@@ -58,7 +58,7 @@ public:
 
     /** Adds the given int to the end of the column. */
     void push_back(int val) {
-        exit_if_not(type_ = 'I', "Column type is not integer");
+        exit_if_not(type_ == 'I', "Column type is not integer");
         DataType* dt = new DataType();
         dt->set_int(val);
         fields_->append(dt);
@@ -66,7 +66,7 @@ public:
 
     /** Adds the given bool to the end of the column. */
     void push_back(bool val) {
-        exit_if_not(type_ = 'B', "Column type is not boolean");
+        exit_if_not(type_ == 'B', "Column type is not boolean");
         DataType* dt = new DataType();
         dt->set_bool(val);
         fields_->append(dt);
@@ -74,7 +74,7 @@ public:
 
     /** Adds the given float to the end of the column. */
     void push_back(float val) {
-        exit_if_not(type_ = 'F', "Column type is not float");
+        exit_if_not(type_ == 'F', "Column type is not float");
         DataType* dt = new DataType();
         dt->set_float(val);
         fields_->append(dt);
@@ -82,48 +82,52 @@ public:
 
     /** Adds the given string to the end of the column. */
     void push_back(String* val) {
-        exit_if_not(type_ = 'S', "Column type is not string");
+        exit_if_not(type_ == 'S', "Column type is not string");
         DataType* dt = new DataType();
         dt->set_string(val);
         fields_->append(dt);
     }
 
+    /** Adds the given field, which must be of this column's type, to the end of the column. */
+    void push_field(DataType* dt) {
+        exit_if_not(dt->get_type() == type_, "Field type does not match the column type");
+        fields_->append(dt);
+    }
+
     /** Gets the int at the specified index. */
     int get_int(size_t idx) {
-        exit_if_not(type_ = 'I', "Column type is not integer");
-        DataType* dt = fields_->get(idx);
-        int res = dt->get_int();
-        delete dt;
-        return res;
+        exit_if_not(type_ == 'I', "Column type is not integer");
+        return fields_->get_view(idx)->get_int();
     }
 
     /** Gets the bool at the specified index. */
     bool get_bool(size_t idx) {
-        exit_if_not(type_ = 'B', "Column type is not boolean");
-        DataType* dt = fields_->get(idx);
-        bool res = dt->get_bool();
-        delete dt;
-        return res;
+        exit_if_not(type_ == 'B', "Column type is not boolean");
+        return fields_->get_view(idx)->get_bool();
     }
 
     /** Gets the float at the specified index. */
     float get_float(size_t idx) {
-        exit_if_not(type_ = 'F', "Column type is not float");
-        DataType* dt = fields_->get(idx);
-        float res = dt->get_float();
-        delete dt;
-        return res;
+        exit_if_not(type_ == 'F', "Column type is not float");
+        return fields_->get_view(idx)->get_float();
     }
 
-    /** Gets the string at the specified index. */
+    /** Gets the string at the specified index. The string is not copied: it stays owned by the
+     *  column and is only valid until the column reads a field of another chunk, so clone() it
+     *  to keep it. */
     String* get_string(size_t idx) {
-        exit_if_not(type_ = 'S', "Column type is not string");
-        DataType* dt = fields_->get(idx);
-        String* res = dt->get_string()->clone();
-        delete dt;
-        return res;
+        exit_if_not(type_ == 'S', "Column type is not string");
+        return fields_->get_view(idx)->get_string();
     }
 
+    /** Returns a copy of the field at the specified index, the caller owns it. An interned
+     *  string is shared by the copy rather than copied. */
+    DataType* get_field(size_t idx) { return fields_->get(idx); }
+
+    /** Returns the field at the specified index without copying it, the column keeps it. It is
+     *  only valid until the column reads a field of another chunk. */
+    DataType* get_view(size_t idx) { return fields_->get_view(idx); }
+
     /** Returns the index of the node on which the field at idx is stored. */
     size_t get_node(size_t idx) { return fields_->get_node(idx); }
 
@@ -151,17 +155,16 @@ public:
     /** Returns a serialized representation of this Column. */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /** Writes a serialized representation of this Column to the given sink. */
+    void serialize(Sink& s) {
         // Serialize the type char
-        char* type = new char[2];
-        type[0] = type_;
-        type[1] = '\0';
-        buff.c(type);
-        delete[] type;
+        s.write(&type_, 1);
         // Serialize the DistributedVector
-        const char* serial_vec = fields_->serialize();
-        buff.c(serial_vec);
-        delete[] serial_vec;
-        return buff.c_str();
+        fields_->serialize(s);
     }
 
     /* Is this column equal to the given object? */
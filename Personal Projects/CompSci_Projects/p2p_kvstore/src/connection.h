@@ -0,0 +1,226 @@
+//lang::Cpp
+
+#pragma once
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <errno.h>
+#include <limits.h>
+#include <mutex>
+#include <atomic>
+
+#include "event_loop.h"
+#include "frame.h"
+
+// The initial size of a connection's receive and send buffers
+#define CONN_BUF_SIZE 16384
+
+/**
+ * One non-blocking socket connection to another node, along with the state needed to read and
+ * write whole frames over it. Every message travels in a frame: a FrameHeader followed by the
+ * payload whose length the header gives.
+ *
+ * Reading: the monitor thread calls read_available() when the socket is readable, which appends
+ * everything the kernel has to a receive buffer, and then takes complete frames out of it with
+ * next_frame(). A frame may arrive split across reads or several may arrive together.
+ *
+ * Writing: any thread may call send_frame(). The frame is written straight to the socket if
+ * nothing is queued ahead of it, and whatever does not fit is queued. The monitor thread calls
+ * flush() when the socket becomes writable again.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Connection : public Object {
+public:
+    int fd_;
+    // The loop watching this connection's socket, external
+    EventLoop* loop_;
+
+    // Receive buffer: bytes [in_start_, in_end_) have been received but not yet handed out
+    char* in_;
+    size_t in_cap_;
+    size_t in_start_;
+    size_t in_end_;
+
+    // Send buffer: bytes [out_start_, out_end_) are queued to be written
+    char* out_;
+    size_t out_cap_;
+    size_t out_start_;
+    size_t out_end_;
+    // The lock that keeps messages sent by different threads from interleaving
+    std::mutex out_mtx_;
+    // The size of both buffers together, readable from any thread
+    std::atomic<size_t> buffer_bytes_;
+
+    /**
+     * Takes over the given connected socket and puts it in non-blocking mode. Nagle's algorithm
+     * is turned off: a frame's header and payload are written separately, and holding back the
+     * payload until the header is acknowledged would add a delayed-ACK timeout to every request.
+     */
+    Connection(int fd, EventLoop* loop) : fd_(fd), loop_(loop), in_(new char[CONN_BUF_SIZE]),
+        in_cap_(CONN_BUF_SIZE), in_start_(0), in_end_(0),
+        out_(new char[CONN_BUF_SIZE]), out_cap_(CONN_BUF_SIZE), out_start_(0), out_end_(0),
+        buffer_bytes_(2 * CONN_BUF_SIZE) {
+        EventLoop::set_nonblocking(fd_);
+        int yes = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+
+    ~Connection() {
+        delete[] in_;
+        delete[] out_;
+    }
+
+    /** Getter for the socket file descriptor */
+    int fd() { return fd_; }
+
+    /** Returns the number of bytes in the receive and send buffers. Safe to call from any
+     *  thread. */
+    size_t buffer_bytes() { return buffer_bytes_; }
+
+    /**
+     * Reads everything that is available on the socket into the receive buffer. Returns false
+     * if the other side closed the connection or there was an error. Payloads previously
+     * returned by next_frame() are invalidated.
+     */
+    bool read_available() {
+        for (;;) {
+            if (in_end_ == in_cap_) make_room_();
+            ssize_t n = recv(fd_, in_ + in_end_, in_cap_ - in_end_, 0);
+            if (n > 0) {
+                in_end_ += n;
+            } else if (n == 0) {
+                return false;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            } else if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * Takes the next complete frame out of the receive buffer, filling in its header and
+     * returning a pointer to its payload, or returns nullptr if no complete frame has arrived yet.
+     * The payload is not copied: it points into the receive buffer and stays valid until the next
+     * call to read_available().
+     */
+    const char* next_frame(FrameHeader& h) {
+        size_t pending = in_end_ - in_start_;
+        if (pending < FRAME_HEADER_SIZE) return nullptr;
+        h.decode(in_ + in_start_);
+        if (pending < FRAME_HEADER_SIZE + h.len_) return nullptr;
+        const char* payload = in_ + in_start_ + FRAME_HEADER_SIZE;
+        in_start_ += FRAME_HEADER_SIZE + h.len_;
+        return payload;
+    }
+
+    /** Makes room at the end of the receive buffer, first by dropping the bytes that were
+     *  already handed out and otherwise by doubling its size. */
+    void make_room_() {
+        size_t pending = in_end_ - in_start_;
+        if (in_start_ > 0) {
+            memmove(in_, in_ + in_start_, pending);
+        } else {
+            char* bigger = new char[in_cap_ * 2];
+            memcpy(bigger, in_, pending);
+            delete[] in_;
+            in_ = bigger;
+            buffer_bytes_ += in_cap_;
+            in_cap_ *= 2;
+        }
+        in_start_ = 0;
+        in_end_ = pending;
+    }
+
+    /**
+     * Sends a frame holding the given payload, or queues whatever cannot be written without
+     * blocking. The header and every part of the payload are handed to the kernel together with
+     * sendmsg(), so the payload is never copied unless the socket is full. Safe to call from any
+     * thread: frames sent by different threads never interleave. Returns false if the connection
+     * failed.
+     */
+    bool send_frame(uint32_t kind, uint64_t id, Payload& payload) {
+        exit_if_not(payload.size() <= UINT32_MAX, "Message is too large to be sent in one frame");
+        char header[FRAME_HEADER_SIZE];
+        FrameHeader(payload.size(), kind, id).encode(header);
+        std::vector<struct iovec> parts(payload.count() + 1);
+        parts[0].iov_base = header;
+        parts[0].iov_len = FRAME_HEADER_SIZE;
+        for (size_t i = 0; i < payload.count(); i++) parts[i + 1] = payload.part(i);
+
+        std::lock_guard<std::mutex> lock(out_mtx_);
+        size_t next = 0;
+        if (out_start_ == out_end_) {
+            // Nothing is queued, so try to write directly
+            while (next < parts.size()) {
+                struct msghdr msg;
+                memset(&msg, 0, sizeof(msg));
+                msg.msg_iov = &parts[next];
+                msg.msg_iovlen = parts.size() - next < IOV_MAX ? parts.size() - next : IOV_MAX;
+                ssize_t n = sendmsg(fd_, &msg, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    if (errno != EINTR) return false;
+                    continue;
+                }
+                // Skip over the parts that were written completely, and the written bytes of the
+                // part that was written partially
+                size_t sent = n;
+                while (next < parts.size() && sent >= parts[next].iov_len) {
+                    sent -= parts[next].iov_len;
+                    next++;
+                }
+                if (sent > 0) {
+                    parts[next].iov_base = (char*)parts[next].iov_base + sent;
+                    parts[next].iov_len -= sent;
+                }
+            }
+            if (next == parts.size()) return true;
+            loop_->want_write(fd_, true);
+        }
+        // The socket is full, so copy what is left into the send queue
+        for (; next < parts.size(); next++) {
+            queue_((const char*)parts[next].iov_base, parts[next].iov_len);
+        }
+        return true;
+    }
+
+    /**
+     * Writes as much of the queued data as the socket accepts. Called by the monitor thread when
+     * the socket becomes writable. Returns false if the connection failed.
+     */
+    bool flush() {
+        std::lock_guard<std::mutex> lock(out_mtx_);
+        while (out_start_ < out_end_) {
+            ssize_t n = ::send(fd_, out_ + out_start_, out_end_ - out_start_, MSG_NOSIGNAL);
+            if (n > 0) out_start_ += n;
+            else if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            else if (errno != EINTR) return false;
+        }
+        out_start_ = out_end_ = 0;
+        loop_->want_write(fd_, false);
+        return true;
+    }
+
+    /** Appends len bytes to the send queue, growing it if needed. out_mtx_ must be held. */
+    void queue_(const char* data, size_t len) {
+        if (out_end_ + len > out_cap_) {
+            size_t queued = out_end_ - out_start_;
+            size_t cap = out_cap_;
+            while (queued + len > cap) cap *= 2;
+            char* bigger = cap == out_cap_ ? out_ : new char[cap];
+            memmove(bigger, out_ + out_start_, queued);
+            if (bigger != out_) delete[] out_;
+            out_ = bigger;
+            buffer_bytes_ += cap - out_cap_;
+            out_cap_ = cap;
+            out_start_ = 0;
+            out_end_ = queued;
+        }
+        memcpy(out_ + out_end_, data, len);
+        out_end_ += len;
+    }
+};
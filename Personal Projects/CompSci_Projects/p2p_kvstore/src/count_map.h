@@ -0,0 +1,244 @@
+//lang::Cpp
+
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+
+#include "hashmap.h"
+#include "string_pool.h"
+#include "row.h"
+
+/**
+ * A map from Strings to 64-bit counts, for counting the rows of a DataFrame by key. A count is
+ * changed in place by increment(), so counting a key that is already in the map allocates
+ * nothing, and merge() adds all of the counts of another map at once. DataFrame::fromCounts()
+ * writes a map out as a two-column DataFrame of keys and counts.
+ *
+ * The keys are copies owned by the map. Counts that were never incremented are 0.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class CountMap : public Object {
+public:
+    HashMap<String, int64_t> map_;
+
+    /** Adds delta to the count of the given key and returns the new count. */
+    int64_t increment(String& key, int64_t delta = 1) { return map_.at(key) += delta; }
+
+    /** Returns the count of the given key. */
+    int64_t get(String& key) { return map_.get(key); }
+
+    /** Returns the number of keys. */
+    size_t size() { return map_.size(); }
+
+    /** Adds every count of the given map to this one. */
+    void merge(CountMap& other) {
+        for (size_t i = 0; i < other.capacity(); i++) {
+            String* k = other.key_at(i);
+            if (k != nullptr) map_.at(*k) += other.count_at(i);
+        }
+    }
+
+    /** Returns the number of slots, for walking the map with full_at(), key_at() and
+     *  count_at(). */
+    size_t capacity() { return map_.capacity(); }
+
+    /** True if the slot at the given index holds a key. */
+    bool full_at(size_t i) { return map_.key_at(i) != nullptr; }
+
+    /** Returns the key in the slot at the given index, or nullptr if the slot is empty. */
+    String* key_at(size_t i) { return map_.key_at(i); }
+
+    /** Returns the count in the slot at the given index, which must not be empty. */
+    int64_t count_at(size_t i) { return map_.value_at(i); }
+};
+
+/**
+ * A map from ints to 64-bit counts, with the same interface as CountMap. The keys and counts are
+ * kept side by side in one array of slots with linear probing, like a HashMap, so the map makes
+ * no allocation per key at all.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class IntCountMap : public Object {
+public:
+    /** One entry of the map. */
+    struct Slot {
+        int key_;
+        bool full_;
+        int64_t count_;
+    };
+
+    Slot* slots_; // owned
+    // The number of slots, always a power of two
+    size_t capacity_;
+    // The number of keys
+    size_t size_;
+
+    IntCountMap() : capacity_(HASHMAP_INITIAL_CAPACITY), size_(0) {
+        slots_ = new Slot[capacity_]();
+    }
+
+    ~IntCountMap() { delete[] slots_; }
+
+    /** Adds delta to the count of the given key and returns the new count. */
+    int64_t increment(int key, int64_t delta = 1) { return slot_(key).count_ += delta; }
+
+    /** Returns the count of the given key. */
+    int64_t get(int key) {
+        for (size_t i = home_(key); slots_[i].full_; i = next_(i)) {
+            if (slots_[i].key_ == key) return slots_[i].count_;
+        }
+        return 0;
+    }
+
+    /** Returns the number of keys. */
+    size_t size() { return size_; }
+
+    /** Adds every count of the given map to this one. */
+    void merge(IntCountMap& other) {
+        for (size_t i = 0; i < other.capacity_; i++) {
+            if (other.slots_[i].full_) slot_(other.slots_[i].key_).count_ += other.slots_[i].count_;
+        }
+    }
+
+    /** Returns the number of slots, for walking the map with full_at(), key_at() and
+     *  count_at(). */
+    size_t capacity() { return capacity_; }
+
+    /** True if the slot at the given index holds a key. */
+    bool full_at(size_t i) { return slots_[i].full_; }
+
+    /** Returns the key in the slot at the given index, which must not be empty. */
+    int key_at(size_t i) {
+        assert(slots_[i].full_);
+        return slots_[i].key_;
+    }
+
+    /** Returns the count in the slot at the given index, which must not be empty. */
+    int64_t count_at(size_t i) {
+        assert(slots_[i].full_);
+        return slots_[i].count_;
+    }
+
+    /** Returns the slot of the given key, adding the key with a count of 0 if it is not in the
+     *  map. */
+    Slot& slot_(int key) {
+        if ((size_ + 1) * HASHMAP_LOAD_DEN > capacity_ * HASHMAP_LOAD_NUM) grow_();
+        size_t i = home_(key);
+        for (; slots_[i].full_; i = next_(i)) {
+            if (slots_[i].key_ == key) return slots_[i];
+        }
+        slots_[i].key_ = key;
+        slots_[i].full_ = true;
+        slots_[i].count_ = 0;
+        size_++;
+        return slots_[i];
+    }
+
+    /** Returns the slot where the given key starts probing. */
+    size_t home_(int key) {
+        return (size_t)(((uint64_t)(uint32_t)key * 0x9E3779B97F4A7C15ULL) >> 32) & (capacity_ - 1);
+    }
+
+    /** Returns the slot after the given one, wrapping around. */
+    size_t next_(size_t i) { return (i + 1) & (capacity_ - 1); }
+
+    /** Doubles the number of slots and puts every key back in its new place. */
+    void grow_() {
+        Slot* old = slots_;
+        size_t old_cap = capacity_;
+        capacity_ *= 2;
+        slots_ = new Slot[capacity_]();
+        for (size_t i = 0; i < old_cap; i++) {
+            if (!old[i].full_) continue;
+            size_t j = home_(old[i].key_);
+            while (slots_[j].full_) j = next_(j);
+            slots_[j] = old[i];
+        }
+        delete[] old;
+    }
+};
+
+/** Returns the key of the given row for a CountMap, from its first column. */
+inline String& count_key_(Row& r, CountMap& counts) {
+    String* key = r.get_string(0);
+    assert(key != nullptr);
+    return *key;
+}
+
+/** Returns the key of the given row for an IntCountMap, from its first column. */
+inline int count_key_(Row& r, IntCountMap& counts) { return r.get_int(0); }
+
+/** Sets the first column of the given row to the key in slot i of the given CountMap, interning
+ *  it into the given pool if there is one and copying it otherwise. */
+inline void set_count_key_(Row& r, CountMap& counts, size_t i, StringPool* strings) {
+    String* key = counts.key_at(i);
+    if (strings != nullptr) r.set_interned(0, strings->intern(*key));
+    else r.set(0, key->clone());
+}
+
+/** Sets the first column of the given row to the key in slot i of the given IntCountMap. */
+inline void set_count_key_(Row& r, IntCountMap& counts, size_t i, StringPool* strings) {
+    r.set(0, counts.key_at(i));
+}
+
+/**
+ * A Rower that counts the rows of a DataFrame by the key in their first column, which is a
+ * string column for a CountMap and an int column for an IntCountMap. If the rower is weighted,
+ * the int in the second column of each row is added instead of 1, so that the DataFrames written
+ * by DataFrame::fromCounts() can be merged back into a map.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+template <class M>
+class CountRower : public Rower {
+public:
+    M& counts_; // external
+    // True if the count of each row is in its second column
+    bool weighted_;
+
+    CountRower(M& counts, bool weighted = false) : counts_(counts), weighted_(weighted) { }
+
+    bool accept(Row& r) override {
+        counts_.increment(count_key_(r, counts_), weighted_ ? r.get_int(1) : 1);
+        return false;
+    }
+};
+
+/**
+ * A Writer that writes one row of key and count for each key of a CountMap or IntCountMap, in the
+ * order of the map's slots. The counts are written to an int column, so they must fit in an int.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+template <class M>
+class CountWriter : public Writer {
+public:
+    M& counts_; // external
+    StringPool* strings_; // external, may be nullptr
+    // The next slot to look at
+    size_t i_;
+    // The number of keys written so far
+    size_t seen_;
+
+    CountWriter(M& counts, StringPool* strings = nullptr) : counts_(counts), strings_(strings),
+        i_(0), seen_(0) { }
+
+    void visit(Row& r) override {
+        while (!counts_.full_at(i_)) i_++;
+        int64_t count = counts_.count_at(i_);
+        exit_if_not(count >= INT_MIN && count <= INT_MAX, "Count does not fit in an int column.");
+        set_count_key_(r, counts_, i_, strings_);
+        r.set(1, (int)count);
+        i_++;
+        seen_++;
+    }
+
+    bool done() override { return seen_ == counts_.size(); }
+};
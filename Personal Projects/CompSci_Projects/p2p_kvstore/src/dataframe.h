@@ -9,6 +9,7 @@
 #include "schema.h"
 #include "column.h"
 #include "row.h"
+#include "count_map.h"
 
 class KDStore;
 class Key;
@@ -122,7 +123,9 @@ public:
     }
     
     /** Return the value at the given column and row. Accessing rows or
-     *  columns out of bounds, or request the wrong type is undefined.*/
+     *  columns out of bounds, or request the wrong type is undefined. A string
+     *  stays owned by the dataframe and is only valid until its column reads
+     *  a row of another chunk. */
     int get_int(size_t col, size_t row) {
         Column* column = dynamic_cast<Column*>(columns_.get(col));
         return column->get_int(row);
@@ -148,27 +151,16 @@ public:
     
     /** Set the fields of the given row object with values from the columns at
          * the given offset.  If the row is not form the same schema as the
-         * dataframe, results are undefined. */
+         * dataframe, results are undefined. The row borrows its strings from the
+         * columns, so it must be refilled before they read rows of other chunks. */
     void fill_row(size_t idx, Row& row) {
         exit_if_not(schema_.get_types()->equals(row.get_types()), 
             "Row's schema does not match the data frame's.");
         for (int j = 0; j < ncols(); j++) {
             Column* col = dynamic_cast<Column*>(columns_.get(j));
-            char type = col->get_type();
-            switch (type) {
-                case 'I':
-                    row.set(j, col->get_int(idx));
-                    break;
-                case 'B':
-                    row.set(j, col->get_bool(idx));
-                    break;
-                case 'F':
-                    row.set(j, col->get_float(idx));
-                    break;
-                case 'S':
-                    row.set(j, col->get_string(idx));
-                    break;
-            }
+            // The row reads the field where it is in the column's cached chunk, and borrows its
+            // string, so filling a row allocates and copies nothing
+            row.set_view(j, col->get_view(idx));
         }
     }
     
@@ -191,9 +183,9 @@ public:
                     col->push_back(row.get_float(j));
                     break;
                 case 'S':
-                    // Clone the string so that the Column and Row can both maintain control
-                    // of their string objects.
-                    col->push_back(row.get_string(j)->clone());
+                    // Clone the field so that the Column and Row can both maintain control
+                    // of their string objects. Interned strings are shared instead.
+                    col->push_field(row.get_field(j)->clone());
                     break;
                 default:
                     exit_if_not(false, "Column has invalid type.");
@@ -292,17 +284,20 @@ public:
     /* Returns a serialized representation of this DataFrame */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this DataFrame to the given sink */
+    void serialize(Sink& s) {
         // Serialize the columns
-        buff.c("[");
+        s.write_str("[");
         size_t width = ncols();
         for (int i = 0; i < width; i++) {
             Column* col = dynamic_cast<Column*>(columns_.get(i));
-            const char* serial_col = col->serialize();
-            buff.c(serial_col);
-            delete[] serial_col;
+            col->serialize(s);
         }
-        buff.c("]");
-        return buff.c_str();
+        s.write_str("]");
     }
 
     /* Checks if this DataFrame equals the given object */
@@ -373,12 +368,28 @@ public:
      * to the given KDStore at the given Key, and then returns the DataFrame.
      */
     static DataFrame* fromStringScalar(Key* k, KDStore* kd, String* val);
+
+    /**
+     * Builds a DataFrame with a string column of the keys of the given map and an int column of
+     * their counts, adds the DataFrame to the given KDStore at the given Key, and then returns the
+     * DataFrame. The keys are interned into the given pool if there is one.
+     */
+    static DataFrame* fromCounts(Key* k, KDStore* kd, CountMap& counts,
+        StringPool* strings = nullptr);
+
+    /**
+     * Builds a DataFrame with an int column of the keys of the given map and an int column of
+     * their counts, adds the DataFrame to the given KDStore at the given Key, and then returns the
+     * DataFrame.
+     */
+    static DataFrame* fromCounts(Key* k, KDStore* kd, IntCountMap& counts);
 };
 
 // Deserializer functions defined below to avoid circular dependencies
 
 /** Builds and returns a Chunk from the bytestream. */
 Chunk* Deserializer::deserialize_chunk() {
+    if (len_ > i_ && current() == CHUNK_BINARY_TAG) return deserialize_binary_chunk_();
     size_t idx = deserialize_size_t();
     size_t size = deserialize_size_t();
     Chunk* c = new Chunk(idx);
@@ -390,6 +401,102 @@ Chunk* Deserializer::deserialize_chunk() {
     return c;
 }
 
+/** Builds and returns a Chunk in the binary format from the bytestream. */
+Chunk* Deserializer::deserialize_binary_chunk_() {
+    exit_if_not(i_ + CHUNK_HEADER_SIZE <= len_, "Chunk is truncated");
+    const char* header = stream_ + i_;
+    char type = header[1];
+    ChunkCodec codec = (ChunkCodec)header[2];
+    size_t size = Serializer::get_u32(header + 4);
+    size_t idx = Serializer::get_u64(header + 8);
+    exit_if_not(size <= CHUNK_SIZE, "Chunk is too large");
+    size_t bitmap = Chunk::bitmap_bytes_(size);
+    exit_if_not(i_ + CHUNK_HEADER_SIZE + bitmap <= len_, "Chunk is truncated");
+    const char* missing = header + CHUNK_HEADER_SIZE;
+    const char* vals = missing + bitmap;
+    // The number of bytes of the values that are left in the stream, and that the values take
+    size_t avail = len_ - i_ - CHUNK_HEADER_SIZE - bitmap;
+    size_t values = 0;
+    // The decoded ints
+    std::vector<int> ints;
+    // For strings, the number of bits of each field's index into the dictionary, the packed
+    // indices, the offsets of the strings and the strings themselves. Raw strings are their
+    // own dictionary, in the order of the fields.
+    size_t width = 0;
+    const char* packed = nullptr;
+    const char* offsets = vals;
+    const char* strs = nullptr;
+    size_t n_strs = size;
+    switch (type) {
+        case 'I':
+            exit_if_not(codec == ChunkCodec::Raw || codec == ChunkCodec::FrameOfRef ||
+                codec == ChunkCodec::DeltaVarint, "Chunk has an unknown codec");
+            ints.resize(size);
+            values = Codec::decode_ints(codec, vals, avail, size, ints.data());
+            break;
+        case 'F': values = 4 * size; break;
+        case 'B': values = bitmap; break;
+        case 'S':
+            if (codec == ChunkCodec::Dictionary) {
+                exit_if_not(avail >= 8, "Chunk is truncated");
+                n_strs = Serializer::get_u32(vals);
+                width = Serializer::get_u32(vals + 4);
+                exit_if_not(width <= 32, "Chunk has a bad bit width");
+                packed = vals + 8;
+                values = 8 + Codec::packed_bytes_(size, width);
+                exit_if_not(values <= avail && n_strs + 1 <= (avail - values) / 4,
+                    "Chunk is truncated");
+                offsets = vals + values;
+            } else {
+                exit_if_not(codec == ChunkCodec::Raw, "Chunk has an unknown codec");
+            }
+            values += 4 * (n_strs + 1);
+            exit_if_not(values <= avail, "Chunk is truncated");
+            strs = vals + values;
+            values += Serializer::get_u32(offsets + 4 * n_strs);
+            break;
+        case 'U': break;
+        default: exit_if_not(false, "Chunk has an unknown type");
+    }
+    exit_if_not(values <= avail, "Chunk is truncated");
+    size_t str_bytes = strs == nullptr ? 0 : vals + values - strs;
+    // A dictionary string is interned once however many fields it is in
+    std::vector<String*> interned;
+    if (packed != nullptr && strings_ != nullptr) interned.resize(n_strs, nullptr);
+    Chunk* c = new Chunk(idx);
+    for (size_t i = 0; i < size; i++) {
+        DataType* dt = new DataType();
+        if (!Chunk::bit_(missing, i)) {
+            switch (type) {
+                case 'I': dt->set_int(ints[i]); break;
+                case 'F': dt->set_float(Serializer::get_float(vals + 4 * i)); break;
+                case 'B': dt->set_bool(Chunk::bit_(vals, i)); break;
+                case 'S': {
+                    size_t s = packed == nullptr ? i : Codec::unpack_(packed, i, width);
+                    exit_if_not(s < n_strs, "Chunk has a bad string index");
+                    size_t start = Serializer::get_u32(offsets + 4 * s);
+                    size_t end = Serializer::get_u32(offsets + 4 * (s + 1));
+                    exit_if_not(start <= end && end <= str_bytes, "Chunk has a bad string offset");
+                    if (!interned.empty()) {
+                        if (interned[s] == nullptr) {
+                            interned[s] = strings_->intern(strs + start, end - start);
+                        }
+                        dt->set_interned(interned[s]);
+                    } else if (strings_ != nullptr) {
+                        dt->set_interned(strings_->intern(strs + start, end - start));
+                    } else {
+                        dt->set_string(new String(strs + start, end - start));
+                    }
+                    break;
+                }
+            }
+        }
+        c->append(dt);
+    }
+    i_ += CHUNK_HEADER_SIZE + bitmap + values;
+    return c;
+}
+
 /** Builds and returns a DistributedVector from the bytestream. */
 DistributedVector* Deserializer::deserialize_dist_vector(KVStore* kv) {
     StrBuff buff;
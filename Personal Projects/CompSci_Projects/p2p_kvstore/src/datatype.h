@@ -28,17 +28,28 @@ class DataType : public Object {
 public:
     union Type t_;
     char type_;
+    // Is the string an interned one from a StringPool, which this object does not own?
+    bool interned_;
+    // Is the string borrowed from something else, such as a cached Chunk, that owns it?
+    bool borrowed_;
 
     /**
      * Constructor
      */
-    DataType() : type_('U') { }
+    DataType() : type_('U'), interned_(false), borrowed_(false) { }
 
     /**
      * Destructor
      */
-    ~DataType() {
-        if (type_ == 'S') delete t_.s; 
+    ~DataType() { clear(); }
+
+    /** Empties this object, making it missing ('U') again so that it can be set to a value of
+     *  any type. */
+    void clear() {
+        if (type_ == 'S' && !interned_ && !borrowed_) delete t_.s;
+        type_ = 'U';
+        interned_ = false;
+        borrowed_ = false;
     }
 
     /**
@@ -66,6 +77,17 @@ public:
         t_.s = val;
         type_ = 'S';
     }
+    // Does not take ownership of the string, which must come from a StringPool.
+    void set_interned(String* val) {
+        set_string(val);
+        interned_ = true;
+    }
+    // Does not take ownership of the string, which must outlive this object. Unlike an interned
+    // string, it is copied by clone().
+    void set_borrowed(String* val) {
+        set_string(val);
+        borrowed_ = true;
+    }
 
     /**
      * These getters return this object's value.
@@ -91,6 +113,18 @@ public:
         return t_.s;
     }
 
+    /** Returns the string and gives up this object's ownership of it, so the caller owns it.
+     *  An interned or borrowed string is copied instead. */
+    String* take_string() {
+        String* res = get_string();
+        if (interned_ || borrowed_) return res->clone();
+        t_.s = nullptr;
+        return res;
+    }
+
+    /** Is this a string from a StringPool? */
+    bool is_interned() { return interned_; }
+
     /**
      * Returns this DataType's type char.
      * */
@@ -107,7 +141,10 @@ public:
             case 'F':
                 res->set_float(t_.f); break;
             case 'S':
-                res->set_string(t_.s->clone()); break;
+                // An interned string is shared rather than copied
+                if (interned_) res->set_interned(t_.s);
+                else res->set_string(t_.s->clone());
+                break;
         }
         return res;
     }
@@ -115,41 +152,24 @@ public:
     /** Returns a char* representation of this DataType. */
     const char* serialize() {
         StrBuff buff;
-        // Serialize the type char
-        char* c_type = new char[2];
-        c_type[0] = type_;
-        c_type[1] = '\0';
-        buff.c(c_type);
-        delete[] c_type;
-        // Serialize the value
-        const char* serial_val;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /** Writes a representation of this DataType to the given sink. */
+    void serialize(Sink& s) {
+        // The type char goes in front of the value
+        s.write(&type_, 1);
         switch (type_) {
-            case 'I': {
-                serial_val = Serializer::serialize_int(t_.i);
-                buff.c(serial_val);
-                delete[] serial_val;
-                break;
-            }
-            case 'B': {
-                serial_val = Serializer::serialize_bool(t_.b);
-                buff.c(serial_val);
-                delete[] serial_val;
-                break;
-            }
-            case 'F': {
-                serial_val = Serializer::serialize_float(t_.f);
-                buff.c(serial_val);
-                delete[] serial_val;
-                break;
-            }
-            case 'S': {
-                serial_val = t_.s->serialize();
-                buff.c(serial_val);
-                delete[] serial_val;
-                break;
-            }
+            case 'I':
+                Serializer::write_int(s, t_.i); break;
+            case 'B':
+                Serializer::write_bool(s, t_.b); break;
+            case 'F':
+                Serializer::write_float(s, t_.f); break;
+            case 'S':
+                t_.s->serialize(s); break;
         }
-        return buff.c_str();
     }
 
     bool equals(Object* o) {
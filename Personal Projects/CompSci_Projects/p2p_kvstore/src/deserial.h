@@ -6,6 +6,8 @@
 #include <sys/socket.h>
 #include "message.h"
 #include "datatype.h"
+#include "string_pool.h"
+#include "memory.h"
 
 class DataFrame; class Column; class DistributedVector; class KVStore; class Chunk;
 
@@ -17,21 +19,31 @@ class DataFrame; class Column; class DistributedVector; class KVStore; class Chu
  */
 class Deserializer : public Object {
 public:
+    /** A run of bytes of the stream, which it borrows and does not copy. */
+    struct Span {
+        const char* data_;
+        size_t len_;
+    };
+
     const char* stream_;
-    int i_; // current location in the stream
-    char* x_;
+    size_t len_; // length of the stream, which need not be null terminated
+    size_t i_; // current location in the stream
+    // The pool that deserialized string fields are interned into, or nullptr to give each field
+    // a String of its own, external
+    StringPool* strings_;
     
 
-    Deserializer(const char* stream) {
+    Deserializer(const char* stream) : Deserializer(stream, strlen(stream)) { }
+
+    Deserializer(const char* stream, size_t len) {
         stream_ = stream;
+        len_ = len;
         i_ = 0;
-        x_ = new char[sizeof(char) + 1];
-        x_[1] = '\0';
+        strings_ = nullptr;
     }
 
-    ~Deserializer() {
-        delete[] x_;
-    }
+    /** Interns the string fields deserialized from now on into the given pool. */
+    void intern_into(StringPool* pool) { strings_ = pool; }
 
     /* Returns the current character in the stream. */
     char current() {
@@ -45,65 +57,56 @@ public:
         return rtrn; 
     }
 
+    /* Returns the text between the braces of the {...} field at this point of the bytestream,
+     * where it is, and steps past the field. */
+    Span field_() {
+        assert(i_ < len_ && step() == '{');
+        const char* start = stream_ + i_;
+        const char* end = (const char*)memchr(start, '}', len_ - i_);
+        assert(end != nullptr);
+        i_ = end + 1 - stream_;
+        return Span{start, (size_t)(end - start)};
+    }
+
+    /* Returns the unsigned number written in decimal in the given span. */
+    static size_t parse_unsigned_(Span s) {
+        assert(s.len_ > 0);
+        size_t res = 0;
+        for (size_t i = 0; i < s.len_; i++) {
+            assert(s.data_[i] >= '0' && s.data_[i] <= '9');
+            res = res * 10 + (s.data_[i] - '0');
+        }
+        return res;
+    }
+
     /* Builds and returns an integer from the bytestream. */
     int deserialize_int() {
-        StrBuff buff;
-        assert(step() == '{');
-        while (current() != '}') {
-            *x_ = step();
-            buff.c(x_);
+        Span s = field_();
+        if (s.len_ > 0 && s.data_[0] == '-') {
+            // Negated as an unsigned number, so that INT_MIN does not overflow
+            return (int)(0u - (unsigned)parse_unsigned_(Span{s.data_ + 1, s.len_ - 1}));
         }
-        assert(step() == '}');
-        char* c_int = buff.c_str();
-        int res = atoi(c_int);
-        delete[] c_int;
-        return res;
+        return (int)parse_unsigned_(s);
     }
 
     /* Builds and returns a size_t from the bytestream. */
     size_t deserialize_size_t() {
-        StrBuff buff;
-        assert(step() == '{');
-        while (current() != '}') {
-            *x_ = step();
-            buff.c(x_);
-        }
-        assert(step() == '}');
-        char* c_size_t = buff.c_str();
-        size_t res = 0;
-        assert(sscanf(c_size_t, "%zu", &res) == 1);
-        delete[] c_size_t;
-        return res;
+        return parse_unsigned_(field_());
     }
 
     /* Builds and returns a float from the bytestream. */
     float deserialize_float() {
-        StrBuff buff;
-        assert(step() == '{');
-        while (current() != '}') {
-            *x_ = step();
-            buff.c(x_);
-        }
-        assert(step() == '}');
-        char* c_float = buff.c_str();
-        float res = atof(c_float);
-        delete[] c_float;
+        Span s = field_();
+        // strtof() stops at the closing brace, so the number is read where it is
+        char* end;
+        float res = strtof(s.data_, &end);
+        assert(end == s.data_ + s.len_);
         return res;
     }
 
     /* Builds and returns a boolean from the bytestream. */
     bool deserialize_bool() {
-        StrBuff buff;
-        assert(step() == '{');
-        while (current() != '}') {
-            *x_ = step();
-            buff.c(x_);
-        }
-        assert(step() == '}');
-        char* c_bool = buff.c_str();
-        bool res = atoi(c_bool);
-        delete[] c_bool;
-        return res;
+        return parse_unsigned_(field_()) != 0;
     }
 
     Object* deserialize_object() {
@@ -117,25 +120,26 @@ public:
 
     /* Builds and returns a Key from the bytestream. */
     Key* deserialize_key() {
-        String* key_str = deserialize_string();
-        assert(key_str != nullptr);
+        // The key string is copied straight out of the stream into the Key
+        Span key = sized_span_();
         size_t idx = deserialize_size_t();
-        const char* key = key_str->c_str();
-        Key* rtrn = new Key(key, idx);
-        delete key_str;
-        return rtrn;
+        return new Key(key.data_, key.len_, idx);
     }
 
     Message* deserialize_message() {
         MsgKind kind = (MsgKind)deserialize_size_t();
         switch (kind) {
-            case MsgKind::Ack:          return new Ack();
+            case MsgKind::Ack:          return deserialize_ack();
             case MsgKind::Register:     return deserialize_register();
             case MsgKind::Directory:    return deserialize_directory();
             case MsgKind::Reply:        return deserialize_reply();
             case MsgKind::Put:          return deserialize_put();
             case MsgKind::Get:          return deserialize_get();
             case MsgKind::WaitAndGet:   return deserialize_wait_get();
+            case MsgKind::MultiPut:     return deserialize_multi_put();
+            case MsgKind::MultiGet:     return deserialize_multi_get();
+            case MsgKind::MultiReply:   return deserialize_multi_reply();
+            case MsgKind::MemoryQuery:  return deserialize_memory_query();
         }
     }
 
@@ -155,57 +159,146 @@ public:
         return new Register(ip, sender);
     }
 
+    /* Builds and returns an Ack message from the bytestream. */
+    Ack* deserialize_ack() {
+        size_t id = deserialize_size_t();
+        assert(step() == '\n');
+        return new Ack(id);
+    }
+
+    /* Builds and returns a MemoryQuery message from the bytestream. */
+    MemoryQuery* deserialize_memory_query() {
+        size_t id = deserialize_size_t();
+        assert(step() == '\n');
+        return new MemoryQuery(id);
+    }
+
+    /* Builds and returns a MemoryUsage from the bytestream. */
+    MemoryUsage* deserialize_memory_usage() {
+        MemoryUsage* res = new MemoryUsage();
+        for (size_t i = 0; i < MEM_KINDS; i++) res->set((MemKind)i, deserialize_size_t());
+        return res;
+    }
+
     /* Builds and returns a Put message from the bytestream. */
     Put* deserialize_put() {
+        size_t id = deserialize_size_t();
         Key* k = deserialize_key();
-        // Extract the blob of serialized data
-        StrBuff buff;
-        while (current() != '\n') {
-            *x_ = step();
-            buff.c(x_);
-        }
-        assert(step() == '\n');
-        return new Put(k, buff.c_str());
+        Span v = rest_span_();
+        return new Put(k, copy_(v), v.len_, id);
     }
 
     /* Builds and returns a Get message from the bytestream. */
     Get* deserialize_get() {
+        size_t id = deserialize_size_t();
         Key* k = deserialize_key();
         assert(step() == '\n');
-        return new Get(k);
+        return new Get(k, id);
     }
 
     /* Builds and returns a WaitAndGet message from the bytestream. */
     WaitAndGet* deserialize_wait_get() {
+        size_t id = deserialize_size_t();
         Key* k = deserialize_key();
         assert(step() == '\n');
-        return new WaitAndGet(k);
+        return new WaitAndGet(k, id);
+    }
+
+    /* Builds and returns a MultiPut message from the bytestream. The arrays of keys, values and
+     * value lengths are new and owned by the caller, as are the keys and values. */
+    MultiPut* deserialize_multi_put() {
+        size_t id = deserialize_size_t();
+        size_t n = deserialize_size_t();
+        Key** keys = new Key*[n];
+        const char** vals = new const char*[n];
+        size_t* lens = new size_t[n];
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = deserialize_key();
+            Span v = sized_span_();
+            vals[i] = copy_(v);
+            lens[i] = v.len_;
+        }
+        assert(step() == '\n');
+        return new MultiPut(n, keys, vals, id, lens);
+    }
+
+    /* Builds and returns a MultiGet message from the bytestream. The array of keys is new and
+     * owned by the caller, as are the keys. */
+    MultiGet* deserialize_multi_get() {
+        size_t id = deserialize_size_t();
+        size_t n = deserialize_size_t();
+        Key** keys = new Key*[n];
+        for (size_t i = 0; i < n; i++) keys[i] = deserialize_key();
+        assert(step() == '\n');
+        return new MultiGet(n, keys, id);
+    }
+
+    /* Builds and returns a MultiReply message from the bytestream. The arrays of values and
+     * value lengths are new and owned by the caller, as are the values. */
+    MultiReply* deserialize_multi_reply() {
+        size_t id = deserialize_size_t();
+        size_t n = deserialize_size_t();
+        const char** vals = new const char*[n];
+        size_t* lens = new size_t[n];
+        for (size_t i = 0; i < n; i++) {
+            Span v = sized_span_();
+            vals[i] = copy_(v);
+            lens[i] = v.len_;
+        }
+        assert(step() == '\n');
+        return new MultiReply(n, vals, id, lens);
+    }
+
+    /* Returns the run of bytes at this point of the bytestream that is preceded by its
+     * serialized length, where it is, and steps past it. */
+    Span sized_span_() {
+        size_t size = deserialize_size_t();
+        assert(i_ + size <= len_);
+        Span res{stream_ + i_, size};
+        i_ += size;
+        return res;
+    }
+
+    /**
+     * Returns the blob of serialized data that makes up the rest of a Put or Reply, which is
+     * everything up to the final newline, where it is. The blob may itself contain newlines or
+     * any other bytes.
+     */
+    Span rest_span_() {
+        assert(len_ > i_ && stream_[len_ - 1] == '\n');
+        Span res{stream_ + i_, len_ - 1 - i_};
+        i_ = len_;
+        return res;
+    }
+
+    /* Returns a new copy of the given span, null terminated after it, that the caller owns. */
+    static char* copy_(Span s) {
+        char* res = new char[s.len_ + 1];
+        memcpy(res, s.data_, s.len_);
+        res[s.len_] = '\0';
+        return res;
     }
 
     /* Builds and returns a Reply message from the bytestream. */
     Reply* deserialize_reply() {
+        size_t id = deserialize_size_t();
         MsgKind req = (MsgKind)deserialize_size_t();
-        // Extract the serialized data
-        StrBuff buff;
-        while (current() != '\n') {
-            *x_ = step();
-            buff.c(x_);
-        }
-        assert(step() == '\n');
-        return new Reply(buff.c_str(), req);
+        Span v = rest_span_();
+        return new Reply(copy_(v), v.len_, req, id);
     }
 
+
     /* Builds and returns a String from the bytestream. */
     String* deserialize_string() {
-        size_t size = deserialize_size_t();
-        char* c_str = new char[size + 1];
-        for (size_t i = 0; i < size; i++) {
-            c_str[i] = step();
-        }
-        c_str[size] = '\0';
-        String* res = new String(c_str);
-        delete[] c_str;
-        return res;
+        Span s = sized_span_();
+        return new String(true, copy_(s), s.len_);
+    }
+
+    /* Returns the interned String for the string at this point of the bytestream, which is read
+     * in place. */
+    String* deserialize_interned_() {
+        Span s = sized_span_();
+        return strings_->intern(s.data_, s.len_);
     }
 
     /* Builds and returns a vector from the bytestream. 
@@ -227,6 +320,7 @@ public:
     IntVector* deserialize_int_vector() {
         IntVector* ivec = new IntVector();
         size_t size = deserialize_size_t();
+        ivec->reserve(size);
         for (size_t i = 0; i < size; i++) {
             int element = deserialize_int();
             ivec->append(element);
@@ -246,14 +340,20 @@ public:
             case 'F':
                 dt->set_float(deserialize_float()); break;
             case 'S':
-                dt->set_string(deserialize_string()); break;
+                if (strings_ != nullptr) dt->set_interned(deserialize_interned_());
+                else dt->set_string(deserialize_string());
+                break;
         }
         return dt;
     }
 
-    /** Builds and returns a Chunk from the bytestream. */
+    /** Builds and returns a Chunk, in either the binary or the text format, from the
+     *  bytestream. */
     Chunk* deserialize_chunk();
 
+    /** Builds and returns a Chunk in the binary format from the bytestream. */
+    Chunk* deserialize_binary_chunk_();
+
     /** Builds and returns a DistributedVector from the bytestream. */
     DistributedVector* deserialize_dist_vector(KVStore* kv);
 
@@ -3,10 +3,38 @@
 #pragma once
 
 #include "datatype.h"
+#include "codec.h"
 #include "kvstore.h"
 
+// The number of fields that each chunk holds
+#define CHUNK_SIZE 5000
+// The number of chunks that are put into, or prefetched from, the KVStore in one batch
+#define CHUNK_BATCH 8
+// The first byte of a Chunk serialized in the binary format. The text format starts with '{'.
+#define CHUNK_BINARY_TAG 'C'
+// The number of bytes of the header of a Chunk serialized in the binary format
+#define CHUNK_HEADER_SIZE 16
+
 /**
  * This class represents a unit of the DistributedVector, i.e. a fixed-size array of fields.
+ *
+ * Chunks are stored in the KVStore in a binary, columnar format written by serialize_binary(),
+ * where the fields are packed one after the other instead of being printed as text:
+ *  - a 16 byte header: CHUNK_BINARY_TAG, the type char of the fields, the ChunkCodec of the
+ *    values, a zero byte, the number of fields as a 32-bit integer and the index of the chunk as
+ *    a 64-bit integer;
+ *  - a bitmap with one bit per field that is set if the field is missing ('U');
+ *  - the values. Raw, they are according to the type: a 32-bit integer or float per field for 'I'
+ *    and 'F', a bitmap of the values for 'B', and for 'S' the offsets of the strings in the string
+ *    section as 32-bit integers, one per field plus one for the end, followed by the string
+ *    section with every string back to back. Ints and strings are usually encoded smaller by one
+ *    of the other codecs described in Codec.
+ * Integers are little-endian and floats are stored bit for bit, so nothing is lost. Each bitmap
+ * is padded to a multiple of 4 bytes, so that the values that follow are aligned if the chunk is.
+ * The value of a missing field is never read, so it is whatever encodes best. All of the fields
+ * of a chunk that are not missing must have the same type, as they do in a Column.
+ *
+ * serialize() still writes the older text format, which deserialize_chunk() reads too.
  * 
  * @author Spencer LaChance <lachance.s@northeastern.edu>
  * @author David Mberingabo <mberingabo.d@husky.neu.edu>
@@ -49,26 +77,150 @@ public:
     /** Getter for the index */
     size_t idx() { return idx_; }
 
-    /** Returns a char* representation of this Chunk */
+    /** Returns the number of bytes that this Chunk and the fields it owns use */
+    size_t memory() {
+        size_t res = sizeof(Chunk) + CHUNK_SIZE * sizeof(DataType*) + size_ * sizeof(DataType);
+        for (size_t i = 0; i < size_; i++) {
+            DataType* dt = fields_[i];
+            if (dt->get_type() == 'S' && !dt->is_interned() && dt->t_.s != nullptr) {
+                res += sizeof(String) + dt->t_.s->size() + 1;
+            }
+        }
+        return res;
+    }
+
+    /** Returns the number of bytes of a bitmap with one bit for each of n fields. */
+    static size_t bitmap_bytes_(size_t n) { return (n + 31) / 32 * 4; }
+
+    /** Returns the ith bit of the given bitmap. */
+    static bool bit_(const char* bits, size_t i) { return (bits[i / 8] >> (i % 8)) & 1; }
+
+    /** Sets the ith bit of the given bitmap. */
+    static void set_bit_(char* bits, size_t i) { bits[i / 8] |= (char)(1 << (i % 8)); }
+
+    /** Returns the type of the fields of this Chunk that are not missing, or 'U' if they all are */
+    char field_type_() {
+        char res = 'U';
+        for (size_t i = 0; i < size_; i++) {
+            char t = fields_[i]->get_type();
+            if (t == 'U') continue;
+            if (res == 'U') res = t;
+            exit_if_not(t == res, "The fields of a Chunk must all have the same type");
+        }
+        return res;
+    }
+
+    /**
+     * Returns a representation of this Chunk in the binary format described above, and stores its
+     * length in len. The values are written with the codec that makes them smallest, or raw if
+     * encode is false. The caller owns the result, which is followed by a null terminator that is
+     * not counted in len but may also hold null bytes of its own.
+     */
+    const char* serialize_binary(size_t& len, bool encode = true) {
+        char type = field_type_();
+        size_t bitmap = bitmap_bytes_(size_);
+        ChunkCodec codec = ChunkCodec::Raw;
+        size_t values = 0;
+        // The ints, or the strings with nullptr for missing fields, in plain arrays for the codecs
+        std::vector<int> ints;
+        std::vector<String*> strs;
+        StrDict* dict = nullptr;
+        switch (type) {
+            case 'I':
+                ints.resize(size_);
+                for (size_t i = 0; i < size_; i++) {
+                    // A missing field repeats the value before it, which every codec stores best
+                    if (fields_[i]->get_type() == 'I') ints[i] = fields_[i]->t_.i;
+                    else ints[i] = i == 0 ? 0 : ints[i - 1];
+                }
+                if (encode) codec = Codec::best_int_codec(ints.data(), size_, values);
+                else values = Codec::int_bytes(codec, ints.data(), size_);
+                break;
+            case 'F': values = 4 * size_; break;
+            case 'B': values = bitmap; break;
+            case 'S':
+                strs.resize(size_);
+                values = 4 * (size_ + 1);
+                for (size_t i = 0; i < size_; i++) {
+                    strs[i] = fields_[i]->get_type() == 'S' ? fields_[i]->t_.s : nullptr;
+                    if (strs[i] != nullptr) values += strs[i]->size();
+                }
+                if (encode) {
+                    dict = new StrDict(strs.data(), size_);
+                    if (dict->encoded_bytes() < values) {
+                        codec = ChunkCodec::Dictionary;
+                        values = dict->encoded_bytes();
+                    }
+                }
+                exit_if_not(values <= UINT32_MAX, "The strings of a Chunk are too long");
+                break;
+        }
+        len = CHUNK_HEADER_SIZE + bitmap + values;
+        // Zeroed, so that only the set bits and the values that are there have to be written
+        char* res = new char[len + 1]();
+        res[0] = CHUNK_BINARY_TAG;
+        res[1] = type;
+        res[2] = (char)codec;
+        Serializer::put_u32(res + 4, (uint32_t)size_);
+        Serializer::put_u64(res + 8, idx_);
+        char* missing = res + CHUNK_HEADER_SIZE;
+        char* vals = missing + bitmap;
+        for (size_t i = 0; i < size_; i++) {
+            if (fields_[i]->get_type() == 'U') set_bit_(missing, i);
+        }
+        switch (type) {
+            case 'I':
+                Codec::encode_ints(codec, ints.data(), size_, vals);
+                break;
+            case 'F':
+                for (size_t i = 0; i < size_; i++) {
+                    if (fields_[i]->get_type() == 'F')
+                        Serializer::put_float(vals + 4 * i, fields_[i]->t_.f);
+                }
+                break;
+            case 'B':
+                for (size_t i = 0; i < size_; i++) {
+                    if (fields_[i]->get_type() == 'B' && fields_[i]->t_.b) set_bit_(vals, i);
+                }
+                break;
+            case 'S': {
+                if (codec == ChunkCodec::Dictionary) {
+                    dict->encode(vals);
+                    break;
+                }
+                char* str_bytes = vals + 4 * (size_ + 1);
+                uint32_t off = 0;
+                for (size_t i = 0; i < size_; i++) {
+                    Serializer::put_u32(vals + 4 * i, off);
+                    if (strs[i] == nullptr) continue;
+                    memcpy(str_bytes + off, strs[i]->c_str(), strs[i]->size());
+                    off += strs[i]->size();
+                }
+                Serializer::put_u32(vals + 4 * size_, off);
+                break;
+            }
+        }
+        delete dict;
+        return res;
+    }
+
+    /** Returns a char* representation of this Chunk in the text format */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /** Writes a representation of this Chunk in the text format to the given sink */
+    void serialize(Sink& s) {
         // Serialize the index
-        const char* serial_idx = Serializer::serialize_size_t(idx_);
-        buff.c(serial_idx);
-        delete[] serial_idx;
+        Serializer::write_size_t(s, idx_);
         // Serialize the size
-        const char* serial_size = Serializer::serialize_size_t(size_);
-        buff.c(serial_size);
-        delete[] serial_size;
+        Serializer::write_size_t(s, size_);
         // Serialize the fields
-        buff.c("[");
-        for (int i = 0; i < size_; i++) {
-            const char* serial_dt = fields_[i]->serialize();
-            buff.c(serial_dt);
-            delete[] serial_dt;
-        }
-        buff.c("]");
-        return buff.c_str();
+        s.write_str("[");
+        for (int i = 0; i < size_; i++) fields_[i]->serialize(s);
+        s.write_str("]");
     }
 };
 
@@ -86,6 +238,8 @@ public:
     size_t size_;
     // The current chunk that is being added to, owned
     Chunk* current_;
+    // The bytes of current_ that are counted in the KVStore's memory(), if it was retrieved
+    size_t current_bytes_;
     // Vector of keys pointing to this DVector's chunks
     Vector* keys_;
     // The current node's KVStore, external
@@ -96,46 +250,153 @@ public:
     KeyBuff* kbuf_;
     // Have all fields been added to this DVector?
     bool is_locked_;
+    // Full chunks that have been serialized but not yet put into the KVStore, along with their
+    // keys. They are put together in one batch.
+    Key* batch_keys_[CHUNK_BATCH]; // external, owned by keys_
+    const char* batch_vals_[CHUNK_BATCH]; // owned
+    // The number of bytes of each queued chunk
+    size_t batch_lens_[CHUNK_BATCH];
+    size_t batch_size_;
+    // The bytes of the queued chunks
+    size_t batch_bytes_;
+    // Serialized chunks that were fetched ahead of being needed, starting with chunk number
+    // ahead_start_. An entry is nullptr once it has been used.
+    Blob* ahead_[CHUNK_BATCH]; // one reference to each is owned
+    // The bytes of each chunk fetched ahead that are counted in the KVStore's memory(), which is
+    // 0 for chunks stored on this node because they are shared with the store
+    size_t ahead_bytes_[CHUNK_BATCH];
+    size_t ahead_start_;
+    size_t ahead_size_;
+    // The number of the chunk that was retrieved last, used to detect sequential scans
+    size_t last_retrieved_;
 
     /** Initialize an empty DistributedVector. The given Key is that of the column that owns this
      *  DVector, the keys for each chunk are built off of it. */
     DistributedVector(KVStore* kv, Key* k) : 
-        size_(0), current_(new Chunk(0)), keys_(new Vector()), kv_(kv), k_(k), 
-        kbuf_(new KeyBuff(k_)), is_locked_(false) { }
+        size_(0), current_(new Chunk(0)), current_bytes_(0), keys_(new Vector()), kv_(kv), k_(k),
+        kbuf_(new KeyBuff(k_)), is_locked_(false), batch_size_(0), batch_bytes_(0), ahead_start_(0),
+        ahead_size_(0), last_retrieved_(SIZE_MAX) { }
 
     /** Initialize a DistributedVector containing the given keys. The given Key is that of the 
      *  column that owns this DVector, the keys for each chunk are built off of it. */
     DistributedVector(KVStore* kv, size_t size, Vector* keys) : 
-        size_(size), current_(nullptr), keys_(keys), kv_(kv), k_(nullptr), kbuf_(nullptr),
-        is_locked_(true) { }
+        size_(size), current_(nullptr), current_bytes_(0), keys_(keys), kv_(kv), k_(nullptr),
+        kbuf_(nullptr), is_locked_(true), batch_size_(0), batch_bytes_(0), ahead_start_(0),
+        ahead_size_(0),
+        last_retrieved_(SIZE_MAX) { }
 
     /** Destructor */
     ~DistributedVector() { 
+        // Chunks of a DVector that was never locked are never read, so they are not stored
+        for (size_t i = 0; i < batch_size_; i++) delete[] batch_vals_[i];
+        kv_->memory().sub(MemKind::DataFrameCache, batch_bytes_);
+        drop_ahead_();
+        drop_current_();
         if (kbuf_ != nullptr) delete kbuf_;
         if (k_ != nullptr) delete k_;
-        if (current_ != nullptr) delete current_;
         delete keys_;
     }
 
-    /** Serializes the current chunk and puts it into the KVStore */
+    /** Serializes the current chunk and queues it to be put into the KVStore with the next
+     *  batch */
     void store_chunk_(size_t idx) {
         kbuf_->c("-");
         kbuf_->c(idx);
         Key* k = kbuf_->get(idx % kv_->num_nodes());
-        kv_->put(*k, current_->serialize());
         keys_->set(k, idx);
-        delete current_;
+        batch_keys_[batch_size_] = k;
+        batch_vals_[batch_size_] = current_->serialize_binary(batch_lens_[batch_size_]);
+        size_t bytes = batch_lens_[batch_size_] + 1;
+        batch_bytes_ += bytes;
+        kv_->memory().add(MemKind::DataFrameCache, bytes);
+        batch_size_++;
+        if (batch_size_ == CHUNK_BATCH) flush_chunks_();
+        drop_current_();
+    }
+
+    /** Makes the given chunk, which was just retrieved, the cached current chunk */
+    void cache_current_(Chunk* c) {
+        current_ = c;
+        current_bytes_ = c->memory();
+        kv_->memory().add(MemKind::DataFrameCache, current_bytes_);
+    }
+
+    /** Deletes the current chunk if there is one */
+    void drop_current_() {
+        if (current_ != nullptr) delete current_;
         current_ = nullptr;
+        kv_->memory().sub(MemKind::DataFrameCache, current_bytes_);
+        current_bytes_ = 0;
+    }
+
+    /** Puts every queued chunk into the KVStore in one batch */
+    void flush_chunks_() {
+        if (batch_size_ == 0) return;
+        // The store takes over the chunks
+        kv_->memory().sub(MemKind::DataFrameCache, batch_bytes_);
+        kv_->multi_put(batch_size_, batch_keys_, batch_vals_, batch_lens_);
+        batch_size_ = 0;
+        batch_bytes_ = 0;
     }
 
-    /** Retrieves the nth chunk from the KVStore and deserialize it. */
+    /** Retrieves the nth chunk from the KVStore and deserialize it. When the chunks are being read
+     *  in order, the next few chunks are fetched along with it in one batch. */
     void retrieve_chunk_(size_t n) {
-        Key* k = dynamic_cast<Key*>(keys_->get(n));
-        const char* serial_chunk = kv_->get(*k);
-        Deserializer ds(serial_chunk);
+        Blob* serial_chunk = nullptr;
+        if (n >= ahead_start_ && n < ahead_start_ + ahead_size_) {
+            serial_chunk = ahead_[n - ahead_start_];
+            ahead_[n - ahead_start_] = nullptr;
+            kv_->memory().sub(MemKind::DataFrameCache, ahead_bytes_[n - ahead_start_]);
+        }
+        if (serial_chunk == nullptr) {
+            drop_ahead_();
+            if (n == last_retrieved_ + 1) {
+                fetch_ahead_(n);
+                serial_chunk = ahead_[0];
+                ahead_[0] = nullptr;
+                kv_->memory().sub(MemKind::DataFrameCache, ahead_bytes_[0]);
+            } else {
+                Key* k = dynamic_cast<Key*>(keys_->get(n));
+                serial_chunk = kv_->get_blob(*k);
+            }
+        }
+        last_retrieved_ = n;
+        // A chunk stored on this node is deserialized straight out of the KVStore
+        Deserializer ds(serial_chunk->data(), serial_chunk->size());
+        ds.intern_into(kv_->string_pool());
         // The chunk is cached because it will likely be needed for the next get()
-        current_ = ds.deserialize_chunk();
-        delete[] serial_chunk;
+        cache_current_(ds.deserialize_chunk());
+        serial_chunk->release();
+    }
+
+    /** Fetches up to CHUNK_BATCH chunks starting with the nth one in one batch */
+    void fetch_ahead_(size_t n) {
+        size_t count = keys_->size() - n;
+        if (count > CHUNK_BATCH) count = CHUNK_BATCH;
+        Key* keys[CHUNK_BATCH];
+        for (size_t i = 0; i < count; i++) keys[i] = dynamic_cast<Key*>(keys_->get(n + i));
+        Blob** vals = kv_->multi_get(count, keys);
+        for (size_t i = 0; i < count; i++) {
+            ahead_[i] = vals[i];
+            ahead_bytes_[i] = 0;
+            if (keys[i]->get_home_node() != kv_->this_node()) {
+                ahead_bytes_[i] = sizeof(Blob) + vals[i]->size() + 1;
+                kv_->memory().add(MemKind::DataFrameCache, ahead_bytes_[i]);
+            }
+        }
+        delete[] vals;
+        ahead_start_ = n;
+        ahead_size_ = count;
+    }
+
+    /** Deletes the chunks that were fetched ahead and not used */
+    void drop_ahead_() {
+        for (size_t i = 0; i < ahead_size_; i++) {
+            if (ahead_[i] == nullptr) continue;
+            ahead_[i]->release();
+            kv_->memory().sub(MemKind::DataFrameCache, ahead_bytes_[i]);
+        }
+        ahead_size_ = 0;
     }
     
     // Appends val to the end of the vector.
@@ -152,8 +413,13 @@ public:
         size_++;
     }
     
-    // Gets the field at the given index.
-    DataType* get(size_t index) {
+    // Gets a copy of the field at the given index, the caller owns it.
+    DataType* get(size_t index) { return get_view(index)->clone(); }
+
+    /** Returns the field at the given index itself, without copying it. The field belongs to the
+     *  cached chunk, so it is only valid until this DVector reads a field of another chunk, is
+     *  unlocked or is deleted. */
+    DataType* get_view(size_t index) {
         exit_if_not(is_locked_, "DVectors can only be queryed once all fields have been added.");
         assert(index < size_);
         // The index of the chunk in the vector
@@ -161,13 +427,11 @@ public:
         // The index of the field in the chunk
         size_t field_idx = index % CHUNK_SIZE;
         if (current_ == nullptr || current_->idx() != chunk_idx) {
-            if (current_ != nullptr) delete current_;
+            drop_current_();
             // Retrieve the chunk from the KVStore
             retrieve_chunk_(chunk_idx);
         }
-        // Retrieve the field from the chunk and clone it so we can delete the chunk later.
-        DataType* res = current_->get(field_idx)->clone();
-        return res;
+        return current_->get(field_idx);
     }
 
     /** Returns the index of the node on which the field at idx is stored. */
@@ -186,14 +450,16 @@ public:
         exit_if_not(!is_locked_, "DistVector is already locked");
         // Put the last chunk in the KVStore if it has any fields
         if (current_->size() > 0) store_chunk_(current_->idx());
+        flush_chunks_();
         is_locked_ = true;
     }
 
     /** Called when more fields must be added to this locked DVector */
     void unlock() {
         exit_if_not(is_locked_, "DistVector is already unlocked");
-        // Delete the cached chunk if there is one
-        if (current_ != nullptr) delete current_;
+        // Delete the cached chunks if there are any
+        drop_current_();
+        drop_ahead_();
         // Get the last chunk from the KVStore.
         size_t last_chunk = keys_->size() - 1;
         retrieve_chunk_(last_chunk);
@@ -202,21 +468,20 @@ public:
 
     /** Returns a char* representation of this DVector */
     const char* serialize() {
+        StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /** Writes a representation of this DVector to the given sink */
+    void serialize(Sink& s) {
         exit_if_not(is_locked_, "DistVector can only be serialized once all fields have been added");
-        StrBuff sbuf;
         // Serialize the size
-        const char* serial_size = Serializer::serialize_size_t(size_);
-        sbuf.c(serial_size);
-        delete[] serial_size;
+        Serializer::write_size_t(s, size_);
         // Serialize the keys
-        sbuf.c("[");
-        for (int i = 0; i < keys_->size(); i++) {
-            const char* serial_key = keys_->get(i)->serialize();
-            sbuf.c(serial_key);
-            delete[] serial_key;
-        }
-        sbuf.c("]");
-        return sbuf.c_str();
+        s.write_str("[");
+        for (int i = 0; i < keys_->size(); i++) keys_->get(i)->serialize(s);
+        s.write_str("]");
     }
 
     /** Getter for the list of keys */
@@ -0,0 +1,244 @@
+//lang::Cpp
+
+#pragma once
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/select.h>
+#include <mutex>
+#include <vector>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#include "object.h"
+
+// The maximum number of ready sockets reported by one call to EventLoop::wait()
+#define MAX_EVENTS 64
+
+/**
+ * The readiness of a file descriptor, as reported by an EventLoop.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Event {
+public:
+    int fd_;
+    bool readable_;
+    bool writable_;
+};
+
+/**
+ * Waits for sockets to become readable or writable. Readiness may be reported edge-triggered,
+ * i.e. a socket is only reported again after new data arrives or buffer space frees up, so
+ * callers must always read and write until the call would block. The loop can be woken from
+ * another thread with wake(), which is how a shutdown or a change of write interest reaches a
+ * loop blocked in wait().
+ *
+ * Use EventLoop::create() to get the best implementation for the platform. Defining USE_SELECT
+ * forces the select() implementation.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class EventLoop : public Object {
+public:
+    // The self-pipe used by wake(): [0] is watched by the loop, [1] is written to
+    int wake_fds_[2];
+
+    EventLoop() {
+        exit_if_not(pipe(wake_fds_) == 0, "Call to pipe() failed");
+        set_nonblocking(wake_fds_[0]);
+        set_nonblocking(wake_fds_[1]);
+    }
+
+    virtual ~EventLoop() {
+        close(wake_fds_[0]);
+        close(wake_fds_[1]);
+    }
+
+    /** Starts watching the given socket for reads (and writes, see want_write()). */
+    virtual void add(int fd) = 0;
+
+    /** Stops watching the given socket. */
+    virtual void remove(int fd) = 0;
+
+    /** Sets whether the caller has data queued for the given socket and wants to know when it
+     *  becomes writable. */
+    virtual void want_write(int fd, bool on) = 0;
+
+    /**
+     * Blocks until at least one socket is ready or wake() is called, and fills events with up
+     * to max (at most MAX_EVENTS) ready sockets. Returns the number of events filled in, or -1
+     * on error.
+     */
+    virtual int wait(Event* events, int max) = 0;
+
+    /** Makes a thread blocked in wait() return. Safe to call from any thread. */
+    void wake() {
+        char c = 0;
+        write(wake_fds_[1], &c, 1);
+    }
+
+    /** Empties the wake pipe after the loop was woken up. */
+    void drain_wake_() {
+        char buf[64];
+        while (read(wake_fds_[0], buf, sizeof(buf)) > 0) { }
+    }
+
+    /** Puts the given file descriptor in non-blocking mode. */
+    static void set_nonblocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    /** Returns a new event loop using the best mechanism available, caller owns it. */
+    static EventLoop* create();
+};
+
+/**
+ * An EventLoop built on select(). It is the portable fallback: it works everywhere, but each
+ * wakeup costs time linear in the number of watched sockets and it cannot watch file descriptors
+ * above FD_SETSIZE.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class SelectLoop : public EventLoop {
+public:
+    // The lock that protects the fields below, which other threads change through want_write()
+    std::mutex mtx_;
+    // Every watched socket
+    std::vector<int> fds_;
+    // The sockets watched for reads and for writes
+    fd_set read_set_;
+    fd_set write_set_;
+
+    SelectLoop() {
+        FD_ZERO(&read_set_);
+        FD_ZERO(&write_set_);
+    }
+
+    void add(int fd) {
+        exit_if_not(fd < FD_SETSIZE, "Socket cannot be watched by select()");
+        std::lock_guard<std::mutex> lock(mtx_);
+        fds_.push_back(fd);
+        FD_SET(fd, &read_set_);
+        wake();
+    }
+
+    void remove(int fd) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (size_t i = 0; i < fds_.size(); i++) {
+            if (fds_[i] == fd) {
+                fds_.erase(fds_.begin() + i);
+                break;
+            }
+        }
+        FD_CLR(fd, &read_set_);
+        FD_CLR(fd, &write_set_);
+        wake();
+    }
+
+    void want_write(int fd, bool on) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (on) FD_SET(fd, &write_set_);
+        else FD_CLR(fd, &write_set_);
+        wake();
+    }
+
+    int wait(Event* events, int max) {
+        fd_set rs, ws;
+        int fdmax = wake_fds_[0];
+        mtx_.lock();
+        rs = read_set_;
+        ws = write_set_;
+        for (int fd : fds_) if (fd > fdmax) fdmax = fd;
+        std::vector<int> fds(fds_);
+        mtx_.unlock();
+        FD_SET(wake_fds_[0], &rs);
+
+        if (select(fdmax + 1, &rs, &ws, NULL, NULL) < 0) return errno == EINTR ? 0 : -1;
+        if (FD_ISSET(wake_fds_[0], &rs)) drain_wake_();
+        int n = 0;
+        for (int fd : fds) {
+            if (n == max) break;
+            bool r = FD_ISSET(fd, &rs);
+            bool w = FD_ISSET(fd, &ws);
+            if (!r && !w) continue;
+            events[n].fd_ = fd;
+            events[n].readable_ = r;
+            events[n].writable_ = w;
+            n++;
+        }
+        return n;
+    }
+};
+
+#ifdef __linux__
+/**
+ * An EventLoop built on edge-triggered epoll. Every socket is registered once for both reads and
+ * writes, so want_write() is a no-op: a socket that filled up is reported again as soon as it
+ * drains, and the kernel only hands back the sockets that are actually ready.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class EpollLoop : public EventLoop {
+public:
+    int epfd_;
+    // The buffer that epoll_wait() fills in
+    struct epoll_event evs_[MAX_EVENTS];
+
+    EpollLoop() {
+        exit_if_not((epfd_ = epoll_create1(0)) >= 0, "Call to epoll_create1() failed");
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = wake_fds_[0];
+        exit_if_not(epoll_ctl(epfd_, EPOLL_CTL_ADD, wake_fds_[0], &ev) == 0,
+            "Call to epoll_ctl() failed");
+    }
+
+    ~EpollLoop() { close(epfd_); }
+
+    void add(int fd) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        exit_if_not(epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev) == 0, "Call to epoll_ctl() failed");
+    }
+
+    void remove(int fd) { epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, NULL); }
+
+    void want_write(int fd, bool on) { }
+
+    int wait(Event* events, int max) {
+        struct epoll_event* evs = evs_;
+        int ready = epoll_wait(epfd_, evs, max < MAX_EVENTS ? max : MAX_EVENTS, -1);
+        if (ready < 0) return errno == EINTR ? 0 : -1;
+        int n = 0;
+        for (int i = 0; i < ready; i++) {
+            if (evs[i].data.fd == wake_fds_[0]) {
+                drain_wake_();
+                continue;
+            }
+            events[n].fd_ = evs[i].data.fd;
+            // Errors and hang-ups are reported as readable so that the following recv() sees them
+            events[n].readable_ = evs[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+            events[n].writable_ = evs[i].events & EPOLLOUT;
+            n++;
+        }
+        return n;
+    }
+};
+#endif
+
+EventLoop* EventLoop::create() {
+#if defined(__linux__) && !defined(USE_SELECT)
+    return new EpollLoop();
+#else
+    return new SelectLoop();
+#endif
+}
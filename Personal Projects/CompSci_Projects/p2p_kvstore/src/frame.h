@@ -0,0 +1,153 @@
+//lang::Cpp
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include "object.h"
+#include "serial.h"
+#include "arena.h"
+
+// The size in bytes of an encoded FrameHeader
+#define FRAME_HEADER_SIZE 16
+// The size in bytes of the blocks that a Payload copies small serialized pieces into
+#define PAYLOAD_BLOCK_SIZE 256
+
+/**
+ * The fixed-size header that comes before every message sent between nodes. It holds the length
+ * of the payload that follows it, so the receiver knows where the message ends without looking
+ * at its contents, along with the message kind and request id so that it can be routed without
+ * being deserialized.
+ *
+ * Encoded as 16 bytes in network byte order: a 4 byte payload length, a 4 byte kind, and an
+ * 8 byte request id.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class FrameHeader {
+public:
+    // The length of the payload in bytes, not including this header
+    uint32_t len_;
+    // The MsgKind of the message in the payload
+    uint32_t kind_;
+    // The request id of the message in the payload
+    uint64_t id_;
+
+    FrameHeader() : len_(0), kind_(0), id_(0) { }
+
+    FrameHeader(uint32_t len, uint32_t kind, uint64_t id) : len_(len), kind_(kind), id_(id) { }
+
+    /** Writes this header into the first FRAME_HEADER_SIZE bytes of out. */
+    void encode(char* out) {
+        uint32_t len = htonl(len_);
+        uint32_t kind = htonl(kind_);
+        uint32_t id_hi = htonl((uint32_t)(id_ >> 32));
+        uint32_t id_lo = htonl((uint32_t)id_);
+        memcpy(out, &len, 4);
+        memcpy(out + 4, &kind, 4);
+        memcpy(out + 8, &id_hi, 4);
+        memcpy(out + 12, &id_lo, 4);
+    }
+
+    /** Reads this header from the first FRAME_HEADER_SIZE bytes of in. */
+    void decode(const char* in) {
+        uint32_t len, kind, id_hi, id_lo;
+        memcpy(&len, in, 4);
+        memcpy(&kind, in + 4, 4);
+        memcpy(&id_hi, in + 8, 4);
+        memcpy(&id_lo, in + 12, 4);
+        len_ = ntohl(len);
+        kind_ = ntohl(kind);
+        id_ = ((uint64_t)ntohl(id_hi) << 32) | ntohl(id_lo);
+    }
+};
+
+/**
+ * The payload of a frame, kept as a list of byte ranges that are sent one after the other rather
+ * than copied into one buffer. It is the Sink that messages are serialized into before they are
+ * sent. Large values, such as serialized chunks, are written with write_borrowed() and referenced
+ * where they already are. Only the small serialized pieces around them are copied, back to back
+ * into blocks allocated in the thread's Arena, so that consecutive pieces make up a single range.
+ * They are all freed at once with the payload, so a payload must be built and deleted by the same
+ * thread.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Payload : public Sink {
+public:
+    // The byte ranges, in order
+    std::vector<struct iovec> parts_;
+    // The total number of bytes
+    size_t len_;
+    // Where the small serialized pieces of this payload are allocated
+    ArenaScope scope_;
+    // Where the next copied piece goes in the current block, and the room left after it
+    char* tail_;
+    size_t tail_room_;
+    // True if the last range ends at tail_, so that the next copied piece can extend it
+    bool tail_open_;
+
+    Payload() : len_(0), tail_(nullptr), tail_room_(0), tail_open_(false) { }
+
+    /** Appends len bytes of data, which must outlive this payload, external */
+    void add(const char* data, size_t len) {
+        if (len == 0) return;
+        struct iovec part;
+        part.iov_base = (void*)data;
+        part.iov_len = len;
+        parts_.push_back(part);
+        len_ += len;
+        tail_open_ = false;
+    }
+
+    /** Appends a copy of len bytes of data */
+    void write(const char* data, size_t len) override {
+        if (len == 0) return;
+        if (len > tail_room_) {
+            size_t size = len > PAYLOAD_BLOCK_SIZE ? len : PAYLOAD_BLOCK_SIZE;
+            tail_ = scope_.alloc(size);
+            tail_room_ = size;
+            tail_open_ = false;
+        }
+        memcpy(tail_, data, len);
+        if (tail_open_) {
+            parts_.back().iov_len += len;
+            len_ += len;
+        } else {
+            add(tail_, len);
+            tail_open_ = true;
+        }
+        tail_ += len;
+        tail_room_ -= len;
+    }
+
+    /** Appends len bytes of data without copying them, they must outlive this payload */
+    void write_borrowed(const char* data, size_t len) override { add(data, len); }
+
+    /** Returns the total number of bytes */
+    size_t size() { return len_; }
+
+    /** Returns the number of byte ranges */
+    size_t count() { return parts_.size(); }
+
+    /** Returns the byte range at the given index */
+    struct iovec& part(size_t i) { return parts_[i]; }
+
+    /** Returns all of the bytes copied into one new null terminated string, caller owns it */
+    char* c_str() {
+        char* res = new char[len_ + 1];
+        size_t at = 0;
+        for (struct iovec& part : parts_) {
+            memcpy(res + at, part.iov_base, part.iov_len);
+            at += part.iov_len;
+        }
+        res[len_] = '\0';
+        return res;
+    }
+};
@@ -0,0 +1,291 @@
+//lang::Cpp
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "object.h"
+
+// The number of slots a HashMap starts with, must be a power of two
+#define HASHMAP_INITIAL_CAPACITY 16
+// A HashMap grows once more than LOAD_NUM / LOAD_DEN of its slots are full
+#define HASHMAP_LOAD_NUM 3
+#define HASHMAP_LOAD_DEN 4
+// The number of slots of the old array that each change to a growing HashMap moves entries out of
+#define HASHMAP_MIGRATE_SLOTS 8
+
+/**
+ * A map from keys of type K to values of type V that keeps all of its entries in one array of
+ * slots (open addressing with linear probing). K must be an Object with clone(), hash() and an
+ * equals(K*) that is resolved at compile time; V is stored by value, so it is usually a number or
+ * a pointer.
+ *
+ * Each slot holds the hash of its key next to the key, so a lookup only looks at a key when the
+ * hashes match, and the probes for one key walk neighbouring slots of the same array. Removing an
+ * entry shifts the entries after it back instead of leaving a tombstone, so lookups never get
+ * slower as entries come and go.
+ *
+ * The map grows to twice its size when it is more than 3/4 full. Growing does not move every
+ * entry at once, which would make one put() as slow as the whole map is big: the old array is
+ * kept next to the new one, every later put(), at() or erase() moves the entries of the next
+ * HASHMAP_MIGRATE_SLOTS old slots over, and lookups look in both arrays until the old one is
+ * empty. The new array is big enough that the old one is always emptied before it fills up.
+ *
+ * The keys are copies owned by the map. The values are not: a map of pointers does not delete
+ * what they point to.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+template <class K, class V>
+class HashMap : public Object {
+public:
+    /** One entry of the map. A slot is empty if its key is nullptr. */
+    struct Slot {
+        size_t hash_;
+        K* key_; // owned
+        V val_;
+    };
+
+    Slot* slots_; // owned
+    // The number of slots, always a power of two
+    size_t capacity_;
+    // The number of entries, in both arrays
+    size_t size_;
+    // The array that the map is growing out of, or nullptr if it is not growing, owned. Its slots
+    // before moved_ are all empty.
+    Slot* old_;
+    // The number of slots of old_
+    size_t old_cap_;
+    // The number of slots of old_ that have been emptied
+    size_t moved_;
+
+    HashMap() : HashMap(HASHMAP_INITIAL_CAPACITY) { }
+
+    /** Creates a map with room for at least the given number of slots. */
+    HashMap(size_t cap) : size_(0), old_(nullptr), old_cap_(0), moved_(0) {
+        capacity_ = HASHMAP_INITIAL_CAPACITY;
+        while (capacity_ < cap) capacity_ *= 2;
+        slots_ = alloc_slots_(capacity_);
+    }
+
+    ~HashMap() {
+        for (size_t i = 0; i < capacity_; i++) delete slots_[i].key_;
+        free(slots_);
+        for (size_t i = 0; i < old_cap_; i++) delete old_[i].key_;
+        free(old_);
+    }
+
+    /** Returns the number of entries. */
+    size_t size() { return size_; }
+
+    /** Returns the number of slots, for walking the map with key_at() and value_at(). While the
+     *  map is growing this counts the slots of both of its arrays. */
+    size_t capacity() { return capacity_ + old_cap_; }
+
+    /** True if the key is in the map. */
+    bool contains(K& k) { return find(k) != nullptr; }
+
+    /** Returns the value at the given key, or V() if it is not in the map. */
+    V get(K& k) {
+        V* v = find(k);
+        return v == nullptr ? V() : *v;
+    }
+
+    /** Returns a pointer to the value at the given key, or nullptr if it is not in the map. The
+     *  pointer is valid until the next put(), at() or erase(). */
+    V* find(K& k) {
+        Slot* s = find_slot_(k, k.hash());
+        return s == nullptr ? nullptr : &s->val_;
+    }
+
+    /** Sets the value at the given key, adding the key if it is not in the map. */
+    void put(K& k, V v) { at(k) = v; }
+
+    /** Returns a reference to the value at the given key, first adding the key with the value
+     *  V() if it is not in the map. The reference is valid until the next put(), at() or
+     *  erase(). */
+    V& at(K& k) {
+        make_room_();
+        size_t h = k.hash();
+        if (old_ != nullptr) {
+            Slot* s = find_in_(old_, old_cap_, k, h);
+            if (s != nullptr) return s->val_;
+        }
+        size_t i = home_(h, capacity_);
+        for (; slots_[i].key_ != nullptr; i = next_(i, capacity_)) {
+            if (slots_[i].hash_ == h && slots_[i].key_->equals(&k)) return slots_[i].val_;
+        }
+        slots_[i].hash_ = h;
+        slots_[i].key_ = k.clone();
+        slots_[i].val_ = V();
+        size_++;
+        return slots_[i].val_;
+    }
+
+    /** Returns the map's own copy of the given key, or nullptr if the key is not in the map. */
+    K* find_key(K& k) {
+        Slot* s = find_slot_(k, k.hash());
+        return s == nullptr ? nullptr : s->key_;
+    }
+
+    /** Adds the given key, which must not be in the map yet, with the given value. The map takes
+     *  ownership of the key itself instead of copying it. */
+    void put_owned(K* k, V v) {
+        make_room_();
+        size_t h = k->hash();
+        assert(find_slot_(*k, h) == nullptr);
+        size_t i = home_(h, capacity_);
+        while (slots_[i].key_ != nullptr) i = next_(i, capacity_);
+        slots_[i].hash_ = h;
+        slots_[i].key_ = k;
+        slots_[i].val_ = v;
+        size_++;
+    }
+
+    /** Removes the entry with the given key and returns true, or returns false if the key is not
+     *  in the map. */
+    bool erase(K& k) {
+        if (old_ != nullptr) migrate_();
+        size_t h = k.hash();
+        if (old_ != nullptr && remove_(old_, old_cap_, k, h)) return true;
+        return remove_(slots_, capacity_, k, h);
+    }
+
+    /** Removes every entry, keeping the slots of the new array. */
+    void clear() {
+        for (size_t i = 0; i < capacity_; i++) delete slots_[i].key_;
+        memset(slots_, 0, capacity_ * sizeof(Slot));
+        for (size_t i = 0; i < old_cap_; i++) delete old_[i].key_;
+        free(old_);
+        old_ = nullptr;
+        old_cap_ = 0;
+        moved_ = 0;
+        size_ = 0;
+    }
+
+    /** Returns the key in the slot at the given index, or nullptr if the slot is empty. The
+     *  slots of the old array of a growing map come after those of the new one. */
+    K* key_at(size_t i) {
+        assert(i < capacity());
+        return i < capacity_ ? slots_[i].key_ : old_[i - capacity_].key_;
+    }
+
+    /** Returns the value in the slot at the given index, which must not be empty. */
+    V& value_at(size_t i) {
+        assert(key_at(i) != nullptr);
+        return i < capacity_ ? slots_[i].val_ : old_[i - capacity_].val_;
+    }
+
+    /** True if the map is still moving entries out of its old array. */
+    bool growing() { return old_ != nullptr; }
+
+    /** Returns the slot where a key with the given hash starts probing in an array with the given
+     *  number of slots. The hash is mixed first because the KVStore picks a shard with the low
+     *  bits of the same hash, so the keys of one shard would otherwise all start in a few of its
+     *  slots. */
+    size_t home_(size_t h, size_t cap) {
+        return (size_t)(((uint64_t)h * 0x9E3779B97F4A7C15ULL) >> 32) & (cap - 1);
+    }
+
+    /** Returns the slot after the given one in an array with the given number of slots, wrapping
+     *  around. */
+    size_t next_(size_t i, size_t cap) { return (i + 1) & (cap - 1); }
+
+    /** Returns the slot of the given key in the given array, or nullptr if it is not there. */
+    Slot* find_in_(Slot* slots, size_t cap, K& k, size_t h) {
+        for (size_t i = home_(h, cap); slots[i].key_ != nullptr; i = next_(i, cap)) {
+            if (slots[i].hash_ == h && slots[i].key_->equals(&k)) return &slots[i];
+        }
+        return nullptr;
+    }
+
+    /** Returns the slot of the given key in either array, or nullptr if it is not in the map. */
+    Slot* find_slot_(K& k, size_t h) {
+        Slot* s = find_in_(slots_, capacity_, k, h);
+        if (s == nullptr && old_ != nullptr) s = find_in_(old_, old_cap_, k, h);
+        return s;
+    }
+
+    /** Removes the entry with the given key from the given array and returns true, or returns
+     *  false if the key is not there. */
+    bool remove_(Slot* slots, size_t cap, K& k, size_t h) {
+        Slot* s = find_in_(slots, cap, k, h);
+        if (s == nullptr) return false;
+        delete s->key_;
+        clear_(slots, cap, s - slots);
+        size_--;
+        return true;
+    }
+
+    /** Empties the slot at the given index of the given array, whose key has been deleted or
+     *  moved, by moving back every following entry of the probe run that may sit at it, so that
+     *  no lookup runs into the hole before reaching its key. */
+    void clear_(Slot* slots, size_t cap, size_t i) {
+        size_t hole = i;
+        for (size_t j = next_(i, cap); slots[j].key_ != nullptr; j = next_(j, cap)) {
+            size_t home = home_(slots[j].hash_, cap);
+            // The entry at j can move to the hole unless its home lies after the hole (cyclically)
+            // and not after j
+            if (((j - home) & (cap - 1)) >= ((j - hole) & (cap - 1))) {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole].key_ = nullptr;
+        slots[hole].val_ = V();
+    }
+
+    /** Returns an array of the given number of empty slots, to be free()d. It is calloc()ed
+     *  instead of new[]ed and zeroed because a large calloc() gets pages that the system zeroes
+     *  when they are first touched, so starting to grow a big map does not stop to clear all of
+     *  its new array. A Slot is a hash, a pointer and a V, so zero bytes are an empty slot. */
+    Slot* alloc_slots_(size_t cap) {
+        Slot* res = (Slot*)calloc(cap, sizeof(Slot));
+        exit_if_not(res != nullptr, "Out of memory for HashMap slots.");
+        return res;
+    }
+
+    /** Gets the map ready for one more entry: moves on with growing if it is growing, and starts
+     *  growing if the new entry would make it more than 3/4 full. */
+    void make_room_() {
+        if (old_ != nullptr) migrate_();
+        if ((size_ + 1) * HASHMAP_LOAD_DEN > capacity_ * HASHMAP_LOAD_NUM) grow_();
+    }
+
+    /** Doubles the number of slots. The entries stay in the old array until they are moved. */
+    void grow_() {
+        // Only reached if the old array is not empty yet, which the migration rate rules out
+        while (old_ != nullptr) migrate_();
+        old_ = slots_;
+        old_cap_ = capacity_;
+        moved_ = 0;
+        capacity_ *= 2;
+        slots_ = alloc_slots_(capacity_);
+    }
+
+    /** Moves the entries of the next HASHMAP_MIGRATE_SLOTS slots of the old array to the new one,
+     *  and drops the old array once it is empty. */
+    void migrate_() {
+        size_t end = moved_ + HASHMAP_MIGRATE_SLOTS;
+        if (end > old_cap_) end = old_cap_;
+        for (; moved_ < end; moved_++) {
+            // Taking an entry out of a slot may move a later entry of its run into it
+            while (old_[moved_].key_ != nullptr) {
+                Slot& s = old_[moved_];
+                size_t j = home_(s.hash_, capacity_);
+                while (slots_[j].key_ != nullptr) j = next_(j, capacity_);
+                slots_[j] = s;
+                clear_(old_, old_cap_, moved_);
+            }
+        }
+        if (moved_ == old_cap_) {
+            free(old_);
+            old_ = nullptr;
+            old_cap_ = 0;
+        }
+    }
+};
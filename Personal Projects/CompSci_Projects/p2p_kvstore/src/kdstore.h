@@ -19,17 +19,18 @@ public:
 
     /** Gets the DataFrame stored at the given key in the KVStore. */
     DataFrame* get(Key& k) {
-        const char* serialized_df = kv_.get(k);
-        Deserializer ds(serialized_df);
+        Blob* serialized_df = kv_.get_blob(k);
+        Deserializer ds(serialized_df->data(), serialized_df->size());
         DataFrame* res = ds.deserialize_dataframe(&kv_, &k);
-        delete[] serialized_df;
+        serialized_df->release();
         return res;
     }
 
     /** Waits until the given key is put into the KVStore and then retrives its value. */
     DataFrame* wait_and_get(Key& k) {
-        const char* serialized_df = kv_.wait_and_get(k);
-        Deserializer ds(serialized_df);
+        size_t size;
+        const char* serialized_df = kv_.wait_and_get(k, size);
+        Deserializer ds(serialized_df, size);
         DataFrame* res = ds.deserialize_dataframe(&kv_, &k);
         delete[] serialized_df;
         return res;
@@ -226,4 +227,24 @@ DataFrame* DataFrame::fromStringScalar(Key* k, KDStore* kd, String* val) {
     res->add_column(col);
     kv->put(*k, res->serialize());
     return res;
+}
+
+/**
+ * Builds a DataFrame with a string column of the keys of the given map and an int column of
+ * their counts, adds the DataFrame to the given KDStore at the given Key, and then returns the
+ * DataFrame. The keys are interned into the given pool if there is one.
+ */
+DataFrame* DataFrame::fromCounts(Key* k, KDStore* kd, CountMap& counts, StringPool* strings) {
+    CountWriter<CountMap> w(counts, strings);
+    return fromVisitor(k, kd, "SI", w);
+}
+
+/**
+ * Builds a DataFrame with an int column of the keys of the given map and an int column of
+ * their counts, adds the DataFrame to the given KDStore at the given Key, and then returns the
+ * DataFrame.
+ */
+DataFrame* DataFrame::fromCounts(Key* k, KDStore* kd, IntCountMap& counts) {
+    CountWriter<IntCountMap> w(counts);
+    return fromVisitor(k, kd, "II", w);
 }
\ No newline at end of file
@@ -12,31 +12,60 @@
  */
 class Key : public Object {
 public:
-    // The string key that the data will be stored at within the store
-    String* key_;
+    // The string key that the data will be stored at within the store. It is part of the Key, so
+    // building a Key allocates only its characters.
+    String key_;
     // The index of the node on which the data is stored
     size_t idx_;
 
     /**
      * Constructor
      */
-    Key(const char* key, size_t idx) {
-        key_ = new String(key);
-        idx_ = idx;
+    Key(const char* key, size_t idx) : key_(key), idx_(idx) { }
+
+    /**
+     * Constructor that copies the first len characters of the given key
+     */
+    Key(const char* key, size_t len, size_t idx) : key_(key, len), idx_(idx) { }
+
+    /**
+     * Constructor that takes ownership of the given key string. Its characters are moved into
+     * the Key, and the String itself is deleted.
+     */
+    Key(String* key, size_t idx) : key_(std::move(*key)), idx_(idx) {
+        delete key;
     }
 
     /**
-     * Destructor
+     * Constructor that moves the characters of the given key string into the Key
+     */
+    Key(String&& key, size_t idx) : key_(std::move(key)), idx_(idx) { }
+
+    /**
+     * Copy constructor, which keeps the hashes that were already computed.
      */
-    ~Key() {
-        delete key_;
+    Key(Key& from) : Object(from), key_(from.key_), idx_(from.idx_) { }
+
+    /**
+     * Move constructor, which takes over the characters of the given Key and leaves it empty.
+     */
+    Key(Key&& from) : Object(from), key_(std::move(from.key_)), idx_(from.idx_) { }
+
+    /**
+     * Move assignment, which takes over the characters of the given Key and leaves it empty.
+     */
+    Key& operator=(Key&& from) {
+        key_ = std::move(from.key_);
+        idx_ = from.idx_;
+        hash_ = from.hash_;
+        return *this;
     }
 
     /**
      * Getter for the key string. 
      */
     String* get_keystring() {
-        return key_;
+        return &key_;
     }
 
     /**
@@ -49,50 +78,95 @@ public:
     /* Returns a serialized representation of this key */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this key to the given sink */
+    void serialize(Sink& s) {
         // Serialize the string
-        const char* serial_k = key_->serialize();
-        buff.c(serial_k);
-        delete[] serial_k;
+        key_.serialize(s);
         // Serialize the node index
-        const char* serial_idx = Serializer::serialize_size_t(idx_);
-        buff.c(serial_idx);
-        delete[] serial_idx;
-        return buff.c_str();
+        Serializer::write_size_t(s, idx_);
     }
 
     /* Return true if this key is equal to the given objects, and false if not. */
     bool equals(Object* o) {
         Key* other = dynamic_cast<Key*>(o);
         if (other == nullptr) return false;
-        return idx_ == other->get_home_node() && key_->equals(other->get_keystring());
+        return idx_ == other->get_home_node() && key_.equals(other->get_keystring());
     }
 
     /** Returns a copy of this Key. */
-    Key* clone() { return new Key(key_->c_str(), idx_); }
+    Key* clone() { return new Key(*this); }
+
+    /** Hashes the key string and the home node together. */
+    size_t hash_me() override {
+        size_t hash = key_.hash();
+        hash ^= idx_ + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        return hash == 0 ? 1 : hash;
+    }
+};
+
+/**
+ * A Key that borrows the characters of its key string instead of owning them, for looking up data
+ * by a key that is built on the fly without allocating. The characters must be null terminated
+ * and must outlive the view. Copying a view with clone() gives an ordinary Key.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class KeyView : public Key {
+public:
+    KeyView(const char* key, size_t len, size_t idx) : Key(StrView(key, len), idx) { }
+
+    /** Takes over the borrowed characters of the given view. */
+    KeyView(KeyView&& from) : Key(std::move(from)) { }
+
+    /** Assigning would free the borrowed characters, so a view cannot be assigned to. */
+    KeyView& operator=(Key&& from) = delete;
+    KeyView& operator=(KeyView&& from) = delete;
+
+    /** Gives the characters back before ~String() would free them. */
+    ~KeyView() { key_.cstr_ = nullptr; }
 };
 
 /** 
- * Uses a StrBuff to build new keys with characters appended to an original key's string.
+ * Uses a StrBuff to build new keys with characters appended to an original key's string. The
+ * original string stays at the start of the buffer, so building a key only appends to it, and
+ * get() allocates nothing but the Key and its characters.
  * @author Jan Vitek <vitekj@me.com>
  */
 class KeyBuff : public Object {
 public:
     Key* orig_; // external
     StrBuff buf_;
+    // The length of the original key string at the start of buf_
+    size_t prefix_;
 
     KeyBuff(Key* orig) : orig_(orig), buf_() {
         buf_.c(*orig_->get_keystring());
+        prefix_ = buf_.size_;
     }
 
     KeyBuff& c(String &s) { buf_.c(s); return *this;  }
     KeyBuff& c(size_t v) { buf_.c(v); return *this; }
     KeyBuff& c(const char* v) { buf_.c(v); return *this; }
 
+    /** Returns a new Key with the built string homed on the given node, and starts over. */
     Key* get(size_t idx) {
-        char* s = buf_.c_str();
-        buf_.c(*orig_->get_keystring());
-        Key* k = new Key(s, idx);
-        delete[] s;
-        return k;
+        Key* res = new Key(buf_.val_, buf_.size_, idx);
+        buf_.size_ = prefix_;
+        return res;
+    }
+
+    /** Returns a view of the built key homed on the given node, and starts over. The view is
+     *  valid until this KeyBuff is changed or deleted. */
+    KeyView view(size_t idx) {
+        buf_.grow_by_(1);
+        buf_.val_[buf_.size_] = '\0';
+        size_t len = buf_.size_;
+        buf_.size_ = prefix_;
+        return KeyView(buf_.val_, len, idx);
     }
 }; // KeyBuff
\ No newline at end of file
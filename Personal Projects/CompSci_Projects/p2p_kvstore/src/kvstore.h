@@ -1,6 +1,6 @@
 //lang::CwC
 
-// Some of the code in this file, particularly the select() loops were interpreted from Beej's Guide to Socking Programming
+// Some of the code in this file, particularly the socket setup was interpreted from Beej's Guide to Socking Programming
 
 #pragma once
 
@@ -17,16 +17,223 @@
 #include <thread>
 #include <unistd.h>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <vector>
+#include <unordered_map>
 
 #include "map.h"
 #include "deserial.h"
+#include "connection.h"
+#include "thread_pool.h"
+#include "blob.h"
+#include "memory.h"
 
 #define PORT "8080"
-// The fixed number of nodes that this network supports (1 server, the rest are clients)
-#define BACKLOG 6
-// The size of the string buffer used to send messages
-#define BUF_SIZE 10000
+// The default number of worker threads that process messages from other nodes
+#define WORKERS 4
+// The number of independently locked shards that a KVStore's local data is split into
+#ifndef STORE_SHARDS
+#define STORE_SHARDS 16
+#endif
+
+/**
+ * A single-slot hand-off between a thread that is waiting on data and the thread that has it: either
+ * the monitor thread receiving the response from another node, or the thread putting the key that a
+ * local wait_and_get() is waiting on. The waiting thread blocks on a condition variable and is woken
+ * as soon as the data arrives.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Completion : public Object {
+public:
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    // Has a response arrived that has not been consumed yet?
+    bool done_;
+    // Was this slot cancelled because the node shut down?
+    bool cancelled_;
+    // The data carried by the response (nullptr for an Ack), external
+    const char* value_;
+    // The number of bytes of value_
+    size_t size_;
+    // The data carried by a MultiReply, external
+    const char** values_;
+    // The number of bytes of each of values_, external
+    size_t* sizes_;
+
+    Completion() : done_(false), cancelled_(false), value_(nullptr), size_(0), values_(nullptr),
+        sizes_(nullptr) { }
+
+    /** Fills the slot with the given response data of the given size and wakes up the waiting
+     *  thread. */
+    void complete(const char* v, size_t size = 0) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        value_ = v;
+        size_ = size;
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    /** Fills the slot with the values of a MultiReply and their sizes and wakes up the waiting
+     *  thread. */
+    void complete(const char** vs, size_t* sizes) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        values_ = vs;
+        sizes_ = sizes;
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    /** Returns the size of the data of the last response, once wait() has returned it. */
+    size_t size() { return size_; }
+
+    /** Returns the sizes of the values of the last MultiReply, once wait() has returned them. */
+    size_t* sizes() { return sizes_; }
+
+    /** Wakes up the waiting thread without a response because the node is shutting down. */
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        cancelled_ = true;
+        cv_.notify_all();
+    }
+
+    /**
+     * Blocks until the slot is completed or cancelled, and then empties it so that it can be
+     * reused by the next request. Returns false if the slot was cancelled.
+     */
+    bool wait(const char*& v) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return done_ || cancelled_; });
+        if (!done_) return false;
+        v = value_;
+        value_ = nullptr;
+        done_ = false;
+        return true;
+    }
+
+    /** Like wait() above, but for the values of a MultiReply. */
+    bool wait(const char**& vs) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] { return done_ || cancelled_; });
+        if (!done_) return false;
+        vs = values_;
+        values_ = nullptr;
+        done_ = false;
+        return true;
+    }
+};
+
+/**
+ * A wait_and_get() for a key that has not been put yet. It is either a thread on this node that is
+ * blocked on a Completion, or a WaitAndGet sent by another node that is answered with a Reply over
+ * the connection it arrived on.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Waiter {
+public:
+    // The slot that the local thread is blocked on, or nullptr for a remote request, external
+    Completion* local_;
+    // The connection that the remote request arrived on, external
+    Connection* conn_;
+    // The id of the remote request
+    size_t id_;
+
+    /** Constructs a waiter for a thread on this node. */
+    Waiter(Completion* local) : local_(local), conn_(nullptr), id_(0) { }
+
+    /** Constructs a waiter for the WaitAndGet with the given id that arrived on the given
+     *  connection. */
+    Waiter(Connection* conn, size_t id) : local_(nullptr), conn_(conn), id_(id) { }
+};
+
+/**
+ * One stripe of the data stored on a KVStore's node. Every key belongs to the shard picked by its
+ * hash, and each shard has a lock of its own, so operations on keys of different shards never wait
+ * on each other and a shard's map can grow while the others are being read.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Shard : public Object {
+public:
+    // The map from string keys to serialized data. The map holds one reference to each Blob.
+    HashMap<String, Blob*> map_;
+    // The wait_and_get()s for keys of this shard that are not in the map yet, keyed by key
+    // string like map_, so a lookup hashes the Key's own String instead of copying it. They are
+    // completed by the put() of their key, so no thread has to poll the map. The vectors are
+    // owned.
+    HashMap<String, std::vector<Waiter>*> waiters_;
+    // The lock that protects map_ and waiters_
+    std::mutex mtx_;
+
+    /** Adds the bytes of this shard's data and of its map and waiters to the given usage. The
+     *  shard must be locked. */
+    void count_memory(MemoryUsage& usage) {
+        size_t values = 0;
+        size_t index = map_.capacity() * sizeof(HashMap<String, Blob*>::Slot);
+        for (size_t i = 0; i < map_.capacity(); i++) {
+            String* k = map_.key_at(i);
+            if (k == nullptr) continue;
+            index += sizeof(String) + k->size() + 1;
+            values += sizeof(Blob) + map_.value_at(i)->size() + 1;
+        }
+        index += waiters_.capacity() * sizeof(HashMap<String, std::vector<Waiter>*>::Slot);
+        for (size_t i = 0; i < waiters_.capacity(); i++) {
+            String* k = waiters_.key_at(i);
+            if (k == nullptr) continue;
+            index += sizeof(String) + k->size() + 1 + sizeof(std::vector<Waiter>)
+                + waiters_.value_at(i)->capacity() * sizeof(Waiter);
+        }
+        usage.set(MemKind::StoreValues, usage.get(MemKind::StoreValues) + values);
+        usage.set(MemKind::StoreIndex, usage.get(MemKind::StoreIndex) + index);
+    }
+
+    /** Registers the given waiter for the given key string. The shard must be locked. */
+    void add_waiter(String& k, Waiter w) {
+        std::vector<Waiter>*& waiting = waiters_.at(k);
+        if (waiting == nullptr) waiting = new std::vector<Waiter>();
+        waiting->push_back(w);
+    }
+
+    /** Moves the waiters for the given key string, if there are any, into the given vector and
+     *  forgets them. The shard must be locked. */
+    void take_waiters(String& k, std::vector<Waiter>& res) {
+        if (waiters_.size() == 0) return;
+        std::vector<Waiter>** waiting = waiters_.find(k);
+        if (waiting == nullptr) return;
+        res.swap(**waiting);
+        delete *waiting;
+        waiters_.erase(k);
+    }
+
+    /** Forgets every waiter, first waking the threads of this node that are waiting if cancel is
+     *  true. The shard must be locked. */
+    void drop_waiters(bool cancel) {
+        for (size_t i = 0; i < waiters_.capacity(); i++) {
+            if (waiters_.key_at(i) == nullptr) continue;
+            std::vector<Waiter>* waiting = waiters_.value_at(i);
+            if (cancel) {
+                for (Waiter& w : *waiting) {
+                    if (w.local_ != nullptr) w.local_->cancel();
+                }
+            }
+            delete waiting;
+        }
+        waiters_.clear();
+    }
+
+    /** Releases the data left in the map. */
+    ~Shard() {
+        for (size_t i = 0; i < map_.capacity(); i++) {
+            if (map_.key_at(i) != nullptr) map_.value_at(i)->release();
+        }
+        drop_waiters(false);
+    }
+};
 
 /**
  * This class represents a key/value store maintained on one node from a larger distributed system.
@@ -42,34 +249,37 @@ public:
     size_t idx_;
     // Number of nodes in the system
     size_t num_nodes_;
-    // The map from string keys to deserialized data blobs
-    Map map_;
-    // Have we received an Ack?
-    bool ack_recvd_;
-    // Data returned in a Reply message after a Get message is sent
-    const char* reply_data_;
-    // Data returned in a Reply message after a WaitAndGet message is sent
-    // WaitAndGet gets its own variable so that there is no confusion between threads running both
-    // get operations
-    const char* wag_reply_data_;
-    // The thread that runs the select() loop
+    // The data stored on this node, split by key hash
+    Shard shards_[STORE_SHARDS];
+    // The pool that string fields of chunks read on this node are interned into, or nullptr if
+    // they are not interned, external
+    StringPool* strings_;
+    // The id given to the next request sent by this node
+    std::atomic<size_t> next_id_;
+    // Requests sent by this node that are still waiting for an Ack or Reply, keyed by request id.
+    // The Completions are owned by the threads waiting on them.
+    std::unordered_map<size_t, Completion*> pending_;
+    // The lock that protects pending_
+    std::mutex pending_mtx_;
+    // The thread that runs the event loop
     std::thread* t_;
-    // Vector of threads that process messages
-    std::vector<std::thread>* threads_;
-    // The lock that prevents data races
-    std::mutex mtx_;
+    // The threads that process incoming Put, Get and WaitAndGet messages
+    ThreadPool* workers_;
     // has this node shut down?
-    bool has_shutdown;
+    std::atomic<bool> has_shutdown;
+    // The bytes used by the parts of this node that are not walked by memory_usage()
+    MemoryCounters memory_;
 
     /**
      * Constructor that initializes an empty KVStore.
      * 
-     * @param idx   The index of the node running this KVStore.
-     * @param nodes The total number of nodes running in the system.
+     * @param idx     The index of the node running this KVStore.
+     * @param nodes   The total number of nodes running in the system.
+     * @param workers The number of threads that process messages from other nodes.
      */
-    KVStore(size_t idx, size_t nodes) : idx_(idx), num_nodes_(nodes), ack_recvd_(false),
-        reply_data_(nullptr), wag_reply_data_(nullptr) {
-        threads_ = new std::vector<std::thread>();
+    KVStore(size_t idx, size_t nodes, size_t workers = WORKERS) : idx_(idx), num_nodes_(nodes),
+        strings_(nullptr), next_id_(1) {
+        workers_ = new ThreadPool(workers);
         startup_();
         // Wait a second for client registration to finish
         sleep(1);
@@ -80,43 +290,57 @@ public:
      */
     ~KVStore() {
         t_->join();
-        for (std::thread& th : *threads_) {
-            if (th.joinable()) {
-                th.join();
-            }
-        }
+        // Deleting the pool waits for the messages that are still being processed
+        delete workers_;
         delete t_;
-        delete threads_;
+        // Nothing uses the connections anymore
+        for (auto& entry : conns_) delete entry.second;
+        delete[] nodes_;
+        delete loop_;
     }
 
     /**
      * Serializes the given data and puts it into the map at the given key.
      * 
      * @param k The key at which the data will be stored
-     * @param v The serialized data that will be stored in the k/v store
+     * @param v The serialized data that will be stored in the k/v store, null terminated
+     */
+    void put(Key& k, const char* v) { put(k, v, strlen(v)); }
+
+    /**
+     * Puts the given data of the given size, which may hold any bytes, into the map at the given
+     * key. The data must be followed by a null terminator that is not counted in the size.
+     *
+     * @param k    The key at which the data will be stored
+     * @param v    The serialized data that will be stored in the k/v store, owned
+     * @param size The number of bytes of data
      */
-    void put(Key& k, const char* v) {
+    void put(Key& k, const char* v, size_t size) {
         size_t dst_node = k.get_home_node();
         // Check if the key corresponds to this node
         if (dst_node == idx_) {
-            // If so, put the data in this KVStore's map
-            mtx_.lock();
-            map_.put(*k.get_keystring(), new String(v));
-            mtx_.unlock();
+            // If so, put the data in this KVStore's map and take the waiters for this key. The map
+            // takes over v rather than copying it.
+            Blob* data = new Blob((char*)v, size);
+            std::vector<Waiter> waiting;
+            Shard& shard = shard_(k);
+            shard.mtx_.lock();
+            Blob*& slot = shard.map_.at(*k.get_keystring());
+            if (slot != nullptr) slot->release();
+            slot = data->retain();
+            shard.take_waiters(*k.get_keystring(), waiting);
+            shard.mtx_.unlock();
+            // Hand the data to everyone who was waiting for it. Our own reference keeps it alive
+            // even if the key is put again meanwhile.
+            for (Waiter& w : waiting) complete_waiter_(w, data);
+            data->release();
         } else {
-            // If not, send a Put message to the correct node
-            Put p(&k, v);
-            const char* msg = p.serialize();
-            send_to_node_(msg, dst_node);
-            // Wait for an Ack confirming that the data was stored successfully
-            while (!ack_recvd_) {
-                sleep(1);
-                if (has_shutdown) exit(-1);
-            }
-            ack_recvd_ = false;
-            delete[] msg;
+            // If not, send a Put message to the correct node and wait for an Ack confirming that
+            // the data was stored successfully
+            Put p(&k, v, size, next_id_++);
+            request_(p, dst_node);
+            delete[] v;
         }
-        delete[] v;
     }
 
     /**
@@ -127,36 +351,60 @@ public:
      * @return The serialized data blob
      */
     const char* get(Key& k) {
+        size_t size;
+        return get(k, size);
+    }
+
+    /**
+     * Like get() above, but also stores the number of bytes of the data in size, for data that
+     * may hold any bytes. The data is followed by a null terminator that is not counted.
+     */
+    const char* get(Key& k, size_t& size) {
         size_t dst_node = k.get_home_node();
         const char* res;
         // Check if this key corresponds to this node
         if (dst_node == idx_) {
-            // If so, get the data from this KVStore's map
-            mtx_.lock();
-            String* serialized_data = dynamic_cast<String*>(map_.get(*k.get_keystring()));
-            assert(serialized_data != nullptr);
-            mtx_.unlock();
-            // Copy the data because the Map owns it
-            String* copy = serialized_data->clone();
-            res = copy->steal();
-            delete copy;
+            // If so, copy the data from this KVStore's map because the caller will own it
+            Blob* b = get_local_(k);
+            size = b->size();
+            res = copy_(b->data(), size);
+            b->release();
         } else {
-            // If not, send a Get message to the correct node
-            Get g(&k);
-            const char* msg = g.serialize();
-            send_to_node_(msg, dst_node);
-            // Wait for a reply with the desired data
-            while (reply_data_ == nullptr) {
-                sleep(1);
-                if (has_shutdown) exit(-1);
-            }
-            res = reply_data_;
-            reply_data_ = nullptr;
-            delete[] msg;
+            // If not, send a Get message to the correct node and wait for a reply with the data
+            Get g(&k, next_id_++);
+            res = request_(g, dst_node, size);
         }
         return res;
     }
 
+    /**
+     * Gets the data stored at the given key without copying it if it is stored on this node.
+     * Prefer this over get() for data that is only read.
+     *
+     * @param k The key at which the reqested data is stored
+     *
+     * @return A reference to the serialized data, which the caller must release()
+     */
+    Blob* get_blob(Key& k) {
+        if (k.get_home_node() == idx_) return get_local_(k);
+        Get g(&k, next_id_++);
+        size_t size;
+        const char* res = request_(g, k.get_home_node(), size);
+        return new Blob((char*)res, size);
+    }
+
+    /**
+     * Returns a new reference to the data at the given key, which must be homed on this node and
+     * be in the map.
+     */
+    Blob* get_local_(Key& k) {
+        Shard& shard = shard_(k);
+        std::lock_guard<std::mutex> lock(shard.mtx_);
+        Blob* b = shard.map_.get(*k.get_keystring());
+        assert(b != nullptr);
+        return b->retain();
+    }
+
     /**
      * Waits until there is data in the store at the given key, and then gets it, deserializes it,
      *  and returns it.
@@ -166,34 +414,178 @@ public:
      * @return The serialized data blob
      */
     const char* wait_and_get(Key& k) {
+        size_t size;
+        return wait_and_get(k, size);
+    }
+
+    /**
+     * Like wait_and_get() above, but also stores the number of bytes of the data in size, for
+     * data that may hold any bytes. The data is followed by a null terminator that is not
+     * counted.
+     */
+    const char* wait_and_get(Key& k, size_t& size) {
         size_t dst_node = k.get_home_node();
         // Check if this key corresponds to this node
         if (dst_node == idx_) {
-            // If so, wait until the data is put into this node's map
-            String* key_string = k.get_keystring();
-            bool contains_key = map_.contains(*key_string);
-            while (!contains_key) {
-                sleep(1);
-                contains_key = map_.contains(*key_string);
-                if (has_shutdown) exit(-1);
+            // If so, get the data right away if it is there, or else register to be handed it by
+            // the put() of this key
+            Completion c;
+            Blob* b = get_or_wait_(k, Waiter(&c));
+            const char* res;
+            if (b != nullptr) {
+                size = b->size();
+                res = copy_(b->data(), size);
+                b->release();
+                return res;
             }
-            // Get the data
-            return get(k);
+            if (!c.wait(res)) exit(-1);
+            size = c.size();
+            return res;
         } else {
-            // If not, send a WaitAndGet message to the correct node
-            WaitAndGet wag(&k);
-            const char* msg = wag.serialize();
-            send_to_node_(msg, dst_node);
-            // Wait for a reply with the desired data
-            while (wag_reply_data_ == nullptr) {
-                sleep(1);
-                if (has_shutdown) exit(-1);
+            // If not, send a WaitAndGet message to the correct node and wait for a reply with the
+            // data
+            WaitAndGet wag(&k, next_id_++);
+            return request_(wag, dst_node, size);
+        }
+    }
+
+    /**
+     * Returns a new reference to the data at the given key, which must be homed on this node, if
+     * it is in the map. If not, registers the given waiter to be completed when the key is put
+     * and returns nullptr. Checking and registering happen under one lock so that a put cannot
+     * slip in between.
+     */
+    Blob* get_or_wait_(Key& k, Waiter w) {
+        Shard& shard = shard_(k);
+        std::lock_guard<std::mutex> lock(shard.mtx_);
+        if (has_shutdown) exit(-1);
+        Blob* b = shard.map_.get(*k.get_keystring());
+        if (b == nullptr) {
+            shard.add_waiter(*k.get_keystring(), w);
+            return nullptr;
+        }
+        return b->retain();
+    }
+
+    /** Returns the shard that the given key, which must be homed on this node, belongs to. */
+    Shard& shard_(Key& k) {
+        return shards_[k.get_keystring()->hash() % STORE_SHARDS];
+    }
+
+    /** Hands the given data that was just put to the given waiter. */
+    void complete_waiter_(Waiter& w, Blob* b) {
+        if (w.local_ != nullptr) {
+            // The Completion owns what it is given
+            w.local_->complete(copy_(b->data(), b->size()), b->size());
+        } else {
+            Reply r(b->data(), b->size(), MsgKind::WaitAndGet, w.id_);
+            send_msg_(w.conn_, r);
+        }
+    }
+
+    /** Returns a new copy of the given data of the given size and the null terminator that
+     *  follows it. The data may hold any bytes. */
+    static char* copy_(const char* v, size_t size) {
+        char* copy = new char[size + 1];
+        memcpy(copy, v, size + 1);
+        return copy;
+    }
+
+    /**
+     * Puts each of the n given values at the key with the same index. The pairs whose keys are
+     * homed on the same other node are sent to it together in one MultiPut, and the MultiPuts to
+     * the different nodes are all in flight at once. Takes ownership of the values, like put().
+     *
+     * @param n    The number of key/value pairs
+     * @param keys The keys at which the data will be stored, external
+     * @param vals The serialized data, the array is external but the values are owned
+     * @param lens The number of bytes of each value, which may then hold any bytes, or nullptr
+     *             if the values are null terminated, external
+     */
+    void multi_put(size_t n, Key** keys, const char** vals, size_t* lens = nullptr) {
+        // Split the pairs by home node
+        std::vector<std::vector<Key*>> node_keys(num_nodes_);
+        std::vector<std::vector<const char*>> node_vals(num_nodes_);
+        std::vector<std::vector<size_t>> node_lens(num_nodes_);
+        for (size_t i = 0; i < n; i++) {
+            size_t dst_node = keys[i]->get_home_node();
+            exit_if_not(dst_node < num_nodes_, "Invalid home node");
+            node_keys[dst_node].push_back(keys[i]);
+            node_vals[dst_node].push_back(vals[i]);
+            node_lens[dst_node].push_back(lens == nullptr ? strlen(vals[i]) : lens[i]);
+        }
+        // Send a MultiPut to every other node that is the home of some of the keys
+        std::vector<Completion> done(num_nodes_);
+        std::vector<size_t> ids(num_nodes_, 0);
+        for (size_t node = 0; node < num_nodes_; node++) {
+            if (node == idx_ || node_keys[node].empty()) continue;
+            MultiPut mp(node_keys[node].size(), node_keys[node].data(), node_vals[node].data(),
+                next_id_++, node_lens[node].data());
+            ids[node] = mp.id();
+            send_request_(mp, node, done[node]);
+        }
+        // Put the local pairs while the others are in flight
+        for (size_t i = 0; i < node_keys[idx_].size(); i++) {
+            put(*node_keys[idx_][i], node_vals[idx_][i], node_lens[idx_][i]);
+        }
+        // Wait for an Ack from every node
+        for (size_t node = 0; node < num_nodes_; node++) {
+            if (ids[node] == 0) continue;
+            const char* ack;
+            finish_request_(ids[node], done[node], ack);
+            for (const char* v : node_vals[node]) delete[] v;
+        }
+    }
+
+    /**
+     * Gets the data stored at each of the n given keys. The keys that are homed on the same other
+     * node are requested from it together in one MultiGet, and the MultiGets to the different
+     * nodes are all in flight at once.
+     *
+     * @param n    The number of keys
+     * @param keys The keys at which the requested data is stored, external
+     *
+     * @return A new array holding a reference to the serialized data at each key, in the same
+     *         order as the keys. The caller owns the array and must release() every reference.
+     *         Data stored on this node is not copied.
+     */
+    Blob** multi_get(size_t n, Key** keys) {
+        Blob** res = new Blob*[n];
+        // Split the keys by home node, remembering where each one came from
+        std::vector<std::vector<Key*>> node_keys(num_nodes_);
+        std::vector<std::vector<size_t>> node_idxs(num_nodes_);
+        for (size_t i = 0; i < n; i++) {
+            size_t dst_node = keys[i]->get_home_node();
+            exit_if_not(dst_node < num_nodes_, "Invalid home node");
+            node_keys[dst_node].push_back(keys[i]);
+            node_idxs[dst_node].push_back(i);
+        }
+        // Send a MultiGet to every other node that is the home of some of the keys
+        std::vector<Completion> done(num_nodes_);
+        std::vector<size_t> ids(num_nodes_, 0);
+        for (size_t node = 0; node < num_nodes_; node++) {
+            if (node == idx_ || node_keys[node].empty()) continue;
+            MultiGet mg(node_keys[node].size(), node_keys[node].data(), next_id_++);
+            ids[node] = mg.id();
+            send_request_(mg, node, done[node]);
+        }
+        // Get the local data while the requests are in flight
+        for (size_t i = 0; i < node_keys[idx_].size(); i++) {
+            res[node_idxs[idx_][i]] = get_local_(*node_keys[idx_][i]);
+        }
+        // Collect the MultiReply from every node
+        for (size_t node = 0; node < num_nodes_; node++) {
+            if (ids[node] == 0) continue;
+            const char** vals;
+            finish_request_(ids[node], done[node], vals);
+            size_t* sizes = done[node].sizes();
+            for (size_t i = 0; i < node_idxs[node].size(); i++) {
+                res[node_idxs[node][i]] = new Blob((char*)vals[i], sizes[i]);
             }
-            const char* res = wag_reply_data_;
-            wag_reply_data_ = nullptr;
-            delete[] msg;
-            return res;
+            delete[] vals;
+            delete[] sizes;
         }
+        return res;
     }
 
     /** Retuns the number of nodes running in the system. */
@@ -202,36 +594,77 @@ public:
     /** Returns the current node's index. */
     size_t this_node() { return idx_; }
 
+    /** Interns the string fields of the chunks read on this node into the given pool from now
+     *  on, so that repeated strings share one String. The pool must outlive this KVStore and all
+     *  DataFrames read through it. */
+    void intern_strings(StringPool* pool) { strings_ = pool; }
+
+    /** Returns the pool that strings are interned into, or nullptr if they are not interned. */
+    StringPool* string_pool() { return strings_; }
+
+    /** Returns the counters that the users of this node add the memory they hold to. */
+    MemoryCounters& memory() { return memory_; }
+
+    /**
+     * Returns how many bytes each part of this node uses right now. The store and the network
+     * buffers are walked, so this takes every shard's lock in turn, and the other parts are read
+     * from memory(). The caller owns the result.
+     */
+    MemoryUsage* memory_usage() {
+        MemoryUsage* res = new MemoryUsage();
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mtx_);
+            shard.count_memory(*res);
+        }
+        size_t net = 0;
+        conns_mtx_.lock();
+        for (auto& entry : conns_) net += entry.second->buffer_bytes();
+        conns_mtx_.unlock();
+        res->set(MemKind::NetworkBuffers, net);
+        res->set(MemKind::DataFrameCache, memory_.get(MemKind::DataFrameCache));
+        res->set(MemKind::PendingMessages, memory_.get(MemKind::PendingMessages));
+        return res;
+    }
+
+    /**
+     * Returns how many bytes each part of the node with the given index uses, asking it with a
+     * MemoryQuery if it is another node. The caller owns the result.
+     */
+    MemoryUsage* memory_usage(size_t node) {
+        if (node == idx_) return memory_usage();
+        MemoryQuery q(next_id_++);
+        const char* res = request_(q, node);
+        Deserializer ds(res);
+        MemoryUsage* usage = ds.deserialize_memory_usage();
+        delete[] res;
+        return usage;
+    }
+
     // ############################# NETWORK-SPECIFIC FIELDS AND METHODS ###########################
 
     char* ip_;
-    // This node's socket file descriptor
+    // This node's listening socket file descriptor
     int fd_;
     // struct that will be filled with basic info in order to generate
     // other full structs used to build sockets
     struct addrinfo hints_;
-    // The file descriptor and address info of another node connecting to this once
-    int their_fd_;
-    struct sockaddr_storage their_addr_;
-    // A string buffer used to send messages
-    char* buffer_;
-    // An array of socket file descriptors to the other nodes
+    // The loop that watches every socket of this node, owned
+    EventLoop* loop_;
+    // Every connection to another node keyed by its socket fd, owned
+    std::unordered_map<int, Connection*> conns_;
+    // The lock that protects conns_
+    std::mutex conns_mtx_;
+    // An array of connections to the other nodes
     // The array indices are the node indices of each node
-    int* nodes_;
-    // master file descriptor list
-    fd_set master_;
-    // temporary fd list used by select()
-    fd_set read_fds_;
-    // the maxmimum fd value in the master list
-    int fdmax_;
+    Connection** nodes_;
 
     // The server's directory containing every client IP
     // Used by the server only
     Directory* directory_;
-    
-    // The file descriptor for the socket connected to the Server
+
+    // The connection to the Server
     // Used by the client only
-    int servfd_;
+    Connection* serv_;
 
     /**
      * Is this node running the role of the server?
@@ -243,16 +676,16 @@ public:
      * Creates the socket that clients will connect to this node through.
      * If this is a client, it also creates a socket to the server and sends it a message containing
      * the client's IP and node index.
-     * 
+     *
      * @param idx The index of the current node.
      */
     void startup_() {
-        buffer_ = new char[BUF_SIZE];
         ip_ = idx_to_ip_(idx_);
         has_shutdown = false;
-        // This is an array that maps the indices of each node to their socket fds
-        nodes_ = new int[BACKLOG];
-        for (int i = 0; i < BACKLOG; i++) nodes_[i] = -1;
+        loop_ = EventLoop::create();
+        // This is an array that maps the indices of each node to their connections
+        nodes_ = new Connection*[num_nodes_];
+        for (size_t i = 0; i < num_nodes_; i++) nodes_[i] = nullptr;
 
         // Fill an addrinfo struct for this node, configuring its options, address, and port
         struct addrinfo *info;
@@ -263,41 +696,50 @@ public:
         // Use the struct to create a socket
         exit_if_not((fd_ = socket(info->ai_family, info->ai_socktype, info->ai_protocol)) >= 0,
             "Call to socket() failed");
+        // Let a restarted node bind its address while old connections are in TIME_WAIT
+        int yes = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
         // Bind the IP and port to the socket
         exit_if_not(bind(fd_, info->ai_addr, info->ai_addrlen) >= 0, "Call to bind() failed");
         freeaddrinfo(info);
+        // Start listening before registering with the server, because other clients may try to
+        // connect to this one as soon as the server tells them about it
+        exit_if_not(listen(fd_, SOMAXCONN) == 0, "Call to listen() failed");
+        EventLoop::set_nonblocking(fd_);
+        loop_->add(fd_);
         if (is_server()) {
             directory_ = new Directory();
         } else {
             // Wait a bit for the server to start up
             usleep(250000);
-            // Calculate the server's IP using its node index (always 0) and use that to generate 
+            // Calculate the server's IP using its node index (always 0) and use that to generate
             // another struct
             struct addrinfo *servinfo;
+            int servfd;
             char* serv_ip = idx_to_ip_(0);
             exit_if_not(getaddrinfo(serv_ip, PORT, &hints_, &servinfo) == 0,
                 "Call to getaddrinfo() failed");
             // Create the socket to the Server
-            exit_if_not((servfd_ = socket(servinfo->ai_family, servinfo->ai_socktype, 
+            exit_if_not((servfd = socket(servinfo->ai_family, servinfo->ai_socktype,
                 servinfo->ai_protocol)) >= 0, "Call to socket() failed");
             // Connect to the Server
-            int cnct = connect(servfd_, servinfo->ai_addr, servinfo->ai_addrlen);
+            int cnct = connect(servfd, servinfo->ai_addr, servinfo->ai_addrlen);
             while (cnct < 0) {
                 // Wait indefinitely until the lead node is available
                 p("Node ", idx_).p(idx_, idx_).pln(": Connection to lead node failed.", idx_);
                 sleep(1);
-                cnct = connect(servfd_, servinfo->ai_addr, servinfo->ai_addrlen);
+                cnct = connect(servfd, servinfo->ai_addr, servinfo->ai_addrlen);
                 if (has_shutdown) exit(-1);
             }
             p("Node ", idx_).p(idx_, idx_).pln(": Connection to lead node succeeded.", idx_);
-            // Add the server fd to the fd/idx map
-            nodes_[0] = servfd_;
+            // Add the server connection to the idx/connection map
+            serv_ = add_connection_(servfd);
+            nodes_[0] = serv_;
             freeaddrinfo(servinfo);
             // Send IP to server in a Register message
             Register reg(new String(ip_), idx_);
-            const char* msg = reg.serialize();
-            exit_if_not(send(servfd_, msg, strlen(msg) + 1, 0) > 0, "Sending IP to server failed");
-            delete[] msg; delete[] serv_ip;
+            exit_if_not(send_msg_(serv_, reg), "Sending IP to server failed");
+            delete[] serv_ip;
         }
         // Start listening for incoming messages
         t_ = new std::thread(&KVStore::monitor_sockets_, this);
@@ -305,151 +747,268 @@ public:
 
     /**
      * Shutdown protocol.
-     * Closes all sockets and deletes all fields.
+     * Closes all sockets and deletes all fields. The connections themselves are deleted by the
+     * destructor, once the threads that use them have finished.
      */
     void shutdown() {
-        has_shutdown = true;
+        // Only shut down once, whether the application or the monitor thread gets here first
+        if (has_shutdown.exchange(true)) return;
+        // Wake up every thread still waiting on a response or on a key to be put
+        pending_mtx_.lock();
+        for (auto& entry : pending_) entry.second->cancel();
+        pending_mtx_.unlock();
+        for (Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mtx_);
+            shard.drop_waiters(true);
+        }
         if (is_server()) {
             delete directory_;
-        } else {
-            close(servfd_);
         }
-        clear_map_();
+        close_connections_();
         close(fd_);
         delete[] ip_;
-        delete[] buffer_;
-        delete[] nodes_;
+        // Make the monitor thread notice the shutdown
+        loop_->wake();
     }
 
     /**
      * Send a message to a specific node.
-     * 
-     * @param msg The message to be sent
+     *
+     * @param m   The message to be sent
      * @param dst The index of the destination node
      */
-    void send_to_node_(const char* msg, size_t dst) {
+    void send_to_node_(Message& m, size_t dst) {
         exit_if_not(dst < num_nodes_, "Invalid dst node index");
-        int fd = nodes_[dst];
-        while (fd == -1) {
+        Connection* c = nodes_[dst];
+        while (c == nullptr) {
             // Wait indefinitely until the desired node is available
             sleep(1);
             p("Node ", idx_).p(idx_, idx_).p(": Could not find a node with index ", idx_)
                 .pln(dst, idx_);
-            fd = nodes_[dst];
+            c = nodes_[dst];
             if (has_shutdown) exit(-1);
         }
-        exit_if_not(send(fd, msg, strlen(msg) + 1, 0) > 0, "Sending msg to other client failed");
+        exit_if_not(send_msg_(c, m), "Sending msg to other client failed");
+    }
+
+    /**
+     * Serializes the given message and sends it in one frame over the given connection. Large
+     * values in the message are sent from where they are, without being copied.
+     * Returns false if the send failed.
+     */
+    bool send_msg_(Connection* c, Message& m) {
+        Payload p;
+        m.serialize(p);
+        return c->send_frame((uint32_t)m.kind(), m.id(), p);
+    }
+
+    /**
+     * Sends the given request to the given node and blocks until the response carrying the same
+     * request id arrives. Returns the data in the response (nullptr for an Ack).
+     */
+    const char* request_(Message& m, size_t dst) {
+        size_t size;
+        return request_(m, dst, size);
+    }
+
+    /** Like request_() above, but also stores the size of the data in the response in size. */
+    const char* request_(Message& m, size_t dst, size_t& size) {
+        Completion c;
+        send_request_(m, dst, c);
+        const char* res;
+        finish_request_(m.id(), c, res);
+        size = c.size();
+        return res;
+    }
+
+    /**
+     * Registers the given Completion to receive the response to the given request, and sends the
+     * request to the given node without waiting for the response.
+     */
+    void send_request_(Message& m, size_t dst, Completion& c) {
+        pending_mtx_.lock();
+        if (has_shutdown) exit(-1);
+        pending_[m.id()] = &c;
+        pending_mtx_.unlock();
+        send_to_node_(m, dst);
+    }
+
+    /**
+     * Blocks until the response to the request with the given id completes the given Completion,
+     * which is then unregistered, and stores the data in the response in res.
+     */
+    template <class T>
+    void finish_request_(size_t id, Completion& c, T& res) {
+        bool completed = c.wait(res);
+        pending_mtx_.lock();
+        pending_.erase(id);
+        pending_mtx_.unlock();
+        if (!completed) exit(-1);
+    }
+
+    /**
+     * Hands the data in a response to the thread waiting on the request with the given id.
+     * Returns false if no thread is waiting on it, in which case the caller still owns the data.
+     */
+    template <class... T>
+    bool complete_(size_t id, T... v) {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        auto it = pending_.find(id);
+        if (it == pending_.end()) {
+            p("Node ", idx_).p(idx_, idx_).p(": Dropping response to unknown request ", idx_)
+                .pln(id, idx_);
+            return false;
+        }
+        it->second->complete(v...);
+        return true;
     }
 
     /**
      * Listens for incoming messages coming from other nodes on the network and then processes them
-     * accordingly.
+     * accordingly. Only the sockets that the event loop reports as ready are looked at.
      */
     void monitor_sockets_() {
-        // length of other node's addrinfo struct
-        socklen_t addrlen;
-        // number of bytes read by recv()
-        int nbytes;
-        // The number of nodes on the network
-        int num_nodes = 1;
-        // The timeout argument for select()
-        struct timeval tv;
-        tv.tv_sec = 3;
-        tv.tv_usec = 0;
-        // Used to concat messages bigger than BUFSIZE
-        StrBuff buff;
-        // Clear the two fd lists
-        FD_ZERO(&master_);
-        FD_ZERO(&read_fds_);
-        // Start listening
-        exit_if_not(listen(fd_, BACKLOG) == 0, "Call to listen() failed");
-        // Add this Client's fd and the Server's to the master list and use them to initialize
-        // the max fd value
-        FD_SET(fd_, &master_);
-        if (is_server()) {
-            fdmax_ = fd_;
-        } else {
-            FD_SET(servfd_, &master_);
-            fdmax_ = fd_ > servfd_ ? fd_ : servfd_;
-        }
-        // Main loop
-        for (;;) {
-            read_fds_ = master_; // Copy the master list
-            // Select the existing socket connections and iterate through them
-            if (select(fdmax_ + 1, &read_fds_, NULL, NULL, &tv) < 0) return;
-            for (int i = 0; i <= fdmax_; i++) {
-                // In case shutdown() was called from the other thread
+        Event events[MAX_EVENTS];
+        while (!has_shutdown) {
+            int n = loop_->wait(events, MAX_EVENTS);
+            if (n < 0) return;
+            for (int i = 0; i < n; i++) {
+                // In case shutdown() was called from another thread
                 if (has_shutdown) return;
-                if (FD_ISSET(i, &read_fds_)) {
-                    if (i == fd_) {
-                        // Found a new connection
-                        if (num_nodes + 1 > BACKLOG) {
-                            // The network is full, do not accept this connection
-                            p("Node ", idx_).p(idx_, idx_)
-                                .pln(": Network is full, cannot accept new connection.", idx_);
-                            continue;
-                        }
-                        num_nodes++;
-                        // The node is receiving a new connection from another one
-                        addrlen = sizeof(their_addr_);
-                        // Accept the connection and add the new socket fd to the master list
-                        exit_if_not((their_fd_ = accept(fd_, (struct sockaddr*)&their_addr_, &addrlen)) >= 0, 
-                            "Call to accept() failed");
-                        FD_SET(their_fd_, &master_);
-                        // Update the max fd value
-                        if (their_fd_ > fdmax_) {
-                            fdmax_ = their_fd_;
-                        }
-                    } else {
-                        // Receiving a message
-                        if ((nbytes = recv(i, buffer_, BUF_SIZE, 0)) <= 0) {
-                            // Connection to the other node was closed or there was an error,
-                            // so shut down
-                            shutdown();
-                            return;
-                        } else {
-                            buff.c(buffer_, nbytes);
-                            // Serialized messages are terminated with newlines, so if the buffer
-                            // does not end with a newline, the message was chunked
-                            if (buffer_[nbytes - 2] != '\n') continue;
-                            // Figure out what kind of message was received
-                            char* serial_msg = buff.c_str();
-                            Deserializer ds(serial_msg);
-                            Message* m = ds.deserialize_message();
-                            assert(m != nullptr);
-                            switch (m->kind()) {
-                                case MsgKind::Directory: process_directory_(m->as_directory()); break;
-                                case MsgKind::Register: process_register_(m->as_register(), i); break;
-                                case MsgKind::Reply: process_reply_(m->as_reply()); break;
-                                case MsgKind::Ack: {
-                                    // Set the value that put() is waiting for above
-                                    ack_recvd_ = true;
-                                    delete m;
-                                    break;
-                                }
-                                case MsgKind::Put:
-                                    threads_->push_back(std::thread(&KVStore::process_put_, this, m->as_put(), i));
-                                    break;
-                                case MsgKind::Get:
-                                    threads_->push_back(std::thread(&KVStore::process_get_, this, m->as_get(), i));
-                                    break;
-                                case MsgKind::WaitAndGet:
-                                    threads_->push_back(std::thread(&KVStore::process_wag_, this, m->as_wait_and_get(), i));
-                                    break;
-                                default: shutdown();
-                            }
-                            delete[] serial_msg;
-                        }
+                if (events[i].fd_ == fd_) {
+                    // Found new connections
+                    accept_connections_();
+                    continue;
+                }
+                Connection* c = find_connection_(events[i].fd_);
+                if (c == nullptr) continue;
+                if (events[i].writable_ && !c->flush()) {
+                    shutdown();
+                    return;
+                }
+                if (events[i].readable_) {
+                    bool open = c->read_available();
+                    // Process every complete frame, including the ones that arrived just
+                    // before the connection was closed
+                    FrameHeader h;
+                    const char* payload;
+                    while ((payload = c->next_frame(h)) != nullptr) dispatch_(h, payload, c);
+                    if (!open) {
+                        // Connection to the other node was closed or there was an error,
+                        // so shut down
+                        shutdown();
+                        return;
                     }
                 }
             }
         }
     }
 
+    /**
+     * Accepts every pending connection from other nodes.
+     */
+    void accept_connections_() {
+        struct sockaddr_storage their_addr;
+        socklen_t addrlen = sizeof(their_addr);
+        for (;;) {
+            int their_fd = accept(fd_, (struct sockaddr*)&their_addr, &addrlen);
+            if (their_fd < 0) {
+                if (errno == EINTR) continue;
+                exit_if_not(errno == EAGAIN || errno == EWOULDBLOCK || has_shutdown,
+                    "Call to accept() failed");
+                return;
+            }
+            if (conns_.size() >= num_nodes_) {
+                // The network is full, do not accept this connection
+                p("Node ", idx_).p(idx_, idx_)
+                    .pln(": Network is full, cannot accept new connection.", idx_);
+                close(their_fd);
+                continue;
+            }
+            add_connection_(their_fd);
+        }
+    }
+
+    /**
+     * Starts watching the given connected socket and returns its new Connection.
+     */
+    Connection* add_connection_(int fd) {
+        Connection* c = new Connection(fd, loop_);
+        conns_mtx_.lock();
+        conns_[fd] = c;
+        conns_mtx_.unlock();
+        loop_->add(fd);
+        return c;
+    }
+
+    /**
+     * Returns the connection with the given socket fd, or nullptr if there is none.
+     */
+    Connection* find_connection_(int fd) {
+        std::lock_guard<std::mutex> lock(conns_mtx_);
+        auto it = conns_.find(fd);
+        return it == conns_.end() ? nullptr : it->second;
+    }
+
+    /**
+     * Processes the frame with the given header and payload that arrived on the given connection
+     * depending on the kind of message it holds. The payload points into the connection's receive
+     * buffer, so it is deserialized in place before this returns.
+     */
+    void dispatch_(FrameHeader& h, const char* payload, Connection* c) {
+        if ((MsgKind)h.kind_ == MsgKind::Ack) {
+            // Wake up the thread waiting in put() above, the header says all there is to know
+            complete_(h.id_, (const char*)nullptr);
+            return;
+        }
+        Deserializer ds(payload, h.len_);
+        Message* m = ds.deserialize_message();
+        assert(m != nullptr && (uint32_t)m->kind() == h.kind_);
+        switch (m->kind()) {
+            case MsgKind::Directory: process_directory_(m->as_directory()); break;
+            case MsgKind::Register: process_register_(m->as_register(), c); break;
+            case MsgKind::Reply: process_reply_(m->as_reply()); break;
+            case MsgKind::Put:
+                submit_(h, std::bind(&KVStore::process_put_, this, m->as_put(), c));
+                break;
+            case MsgKind::Get:
+                submit_(h, std::bind(&KVStore::process_get_, this, m->as_get(), c));
+                break;
+            case MsgKind::WaitAndGet:
+                submit_(h, std::bind(&KVStore::process_wag_, this, m->as_wait_and_get(), c));
+                break;
+            case MsgKind::MultiPut:
+                submit_(h, std::bind(&KVStore::process_multi_put_, this, m->as_multi_put(), c));
+                break;
+            case MsgKind::MultiGet:
+                submit_(h, std::bind(&KVStore::process_multi_get_, this, m->as_multi_get(), c));
+                break;
+            case MsgKind::MultiReply: process_multi_reply_(m->as_multi_reply()); break;
+            case MsgKind::MemoryQuery:
+                submit_(h, std::bind(&KVStore::process_memory_query_, this,
+                    m->as_memory_query(), c));
+                break;
+            default: shutdown();
+        }
+    }
+
+    /**
+     * Hands the processing of a message to the workers. The payload of the message's frame, whose
+     * header is given, counts as pending in memory() until a worker has processed it.
+     */
+    void submit_(FrameHeader& h, std::function<void()> process) {
+        size_t bytes = h.len_;
+        memory_.add(MemKind::PendingMessages, bytes);
+        workers_->submit([this, process, bytes] {
+            process();
+            memory_.sub(MemKind::PendingMessages, bytes);
+        });
+    }
+
     /**
      * Client function
      * Parse the directory message sent from the server.
-     * 
+     *
      * @param directory The directory
      */
     void process_directory_(Directory* directory) {
@@ -465,137 +1024,192 @@ public:
     /**
      * Process the given Register message sent by another node wanting to connect with this one.
      */
-    void process_register_(Register* reg, int fd) {
+    void process_register_(Register* reg, Connection* c) {
         char* new_ip = reg->get_ip()->c_str();
         size_t new_idx = reg->get_sender();
+        exit_if_not(new_idx < num_nodes_, "Register was sent by an invalid node index");
         if (is_server()) {
             // A client is registering with the server
             // Add the new IP to the directory
             directory_->add_client(new_ip, new_idx);
             // Send the updated directory back to the client
-            const char* serial_directory = directory_->serialize();
-            exit_if_not(send(fd, serial_directory, strlen(serial_directory) + 1, 0) > 0,
-                "Call to send() failed");
-            delete[] serial_directory;
+            exit_if_not(send_msg_(c, *directory_), "Call to send() failed");
         }
-        // Keep track of the sender's socket fd and node index
-        nodes_[new_idx] = fd;
+        // Keep track of the sender's connection and node index
+        nodes_[new_idx] = c;
         delete reg;
     }
 
+    /**
+     * Hands the data in the given Reply to the thread waiting in get() or wait_and_get() above.
+     */
     void process_reply_(Reply* rep) {
-        MsgKind req = rep->get_request();
-        const char* v = rep->get_value();
-        // Set the values that get() and wait_and_get() wait for above
-        if (req == MsgKind::WaitAndGet)
-            wag_reply_data_ = v;
-        else
-            reply_data_ = v;
+        if (!complete_(rep->id(), rep->get_value(), rep->get_size())) delete[] rep->get_value();
+        delete rep;
+    }
+
+    /**
+     * Hands the values in the given MultiReply to the thread waiting in multi_get() above.
+     */
+    void process_multi_reply_(MultiReply* rep) {
+        if (!complete_(rep->id(), rep->get_values(), rep->get_sizes())) {
+            for (size_t i = 0; i < rep->size(); i++) delete[] rep->get_value(i);
+            delete[] rep->get_values();
+            delete[] rep->get_sizes();
+        }
         delete rep;
     }
 
     /**
      * Processes the given Put message.
-     * 
-     * @param p  The message
-     * @param fd The socket fd to send the Ack back to
+     *
+     * @param p The message
+     * @param c The connection to send the Ack back over
      */
-    void process_put_(Put* p, int fd) {
+    void process_put_(Put* p, Connection* c) {
         Key* k = p->get_key();
         const char* v = p->get_value();
         // Ensure that this message was sent to the right node
         exit_if_not(k->get_home_node() == idx_, "Put was sent to incorrect node");
-        put(*k, v);
+        put(*k, v, p->get_size());
 
         // Reply with an Ack confirming that the put operation was successful
-        Ack* a = new Ack();
-        const char* msg = a->serialize();
-        exit_if_not(send(fd, msg, strlen(msg) + 1, 0) > 0, "Call to send() failed");
-        delete p; delete k; delete a; delete[] msg;
+        Ack a(p->id());
+        exit_if_not(send_msg_(c, a), "Call to send() failed");
+        delete p; delete k;
     }
 
     /**
-     * Starts the get operation in a separate thread
+     * Processes the given Get message, on one of the worker threads
      */
-    void process_get_(Get* g, int fd) {
+    void process_get_(Get* g, Connection* c) {
         Key* k = g->get_key();
         // Ensure that this message was sent to the right node
         exit_if_not(k->get_home_node() == idx_, "Put was sent to incorrect node");
-        const char* res = get(*k);
+        Blob* res = get_local_(*k);
 
-        // Send back a Reply with the data
-        Reply r(res, MsgKind::Get);
-        const char* msg = r.serialize();
-        exit_if_not(send(fd, msg, strlen(msg) + 1, 0) > 0, "Call to send() failed");
-        delete g; delete k; delete[] msg; delete[] res;
+        // Send back a Reply with the data, straight from the map
+        Reply r(res->data(), res->size(), MsgKind::Get, g->id());
+        exit_if_not(send_msg_(c, r), "Call to send() failed");
+        res->release();
+        delete g; delete k;
     }
 
     /**
-     * Starts the wait_and_get operation in a separate thread
+     * Processes the given WaitAndGet message, on one of the worker threads. If the key has not
+     * been put yet, the request is parked without blocking the worker, and put() sends the Reply.
      */
-    void process_wag_(WaitAndGet* wag, int fd) {
+    void process_wag_(WaitAndGet* wag, Connection* c) {
         Key* k = wag->get_key();
         // Ensure that this message was sent to the right node
         exit_if_not(k->get_home_node() == idx_, "Put was sent to incorrect node");
-        const char* res = wait_and_get(*k);
+        Blob* res = get_or_wait_(*k, Waiter(c, wag->id()));
+        if (res != nullptr) {
+            // Send back a Reply with the data
+            Reply r(res->data(), res->size(), MsgKind::WaitAndGet, wag->id());
+            exit_if_not(send_msg_(c, r), "Call to send() failed");
+            res->release();
+        }
+        delete wag; delete k;
+    }
+
+    /**
+     * Processes the given MultiPut message, on one of the worker threads.
+     *
+     * @param mp The message
+     * @param c  The connection to send the Ack back over
+     */
+    void process_multi_put_(MultiPut* mp, Connection* c) {
+        for (size_t i = 0; i < mp->size(); i++) {
+            Key* k = mp->get_key(i);
+            // Ensure that this message was sent to the right node
+            exit_if_not(k->get_home_node() == idx_, "MultiPut was sent to incorrect node");
+            put(*k, mp->get_value(i), mp->get_size(i));
+            delete k;
+        }
 
-        // Send back a Reply with the data
-        Reply r(res, MsgKind::WaitAndGet);
-        const char* msg = r.serialize();
-        exit_if_not(send(fd, msg, strlen(msg) + 1, 0) > 0, "Call to send() failed");
-        delete wag; delete k; delete[] msg; delete[] res;
+        // Reply with one Ack confirming that every put operation was successful
+        Ack a(mp->id());
+        exit_if_not(send_msg_(c, a), "Call to send() failed");
+        delete[] mp->keys_; delete[] mp->vals_; delete[] mp->lens_; delete mp;
+    }
+
+    /**
+     * Processes the given MultiGet message, on one of the worker threads
+     */
+    void process_multi_get_(MultiGet* mg, Connection* c) {
+        size_t n = mg->size();
+        Blob** blobs = new Blob*[n];
+        const char** res = new const char*[n];
+        size_t* sizes = new size_t[n];
+        for (size_t i = 0; i < n; i++) {
+            Key* k = mg->get_key(i);
+            // Ensure that this message was sent to the right node
+            exit_if_not(k->get_home_node() == idx_, "MultiGet was sent to incorrect node");
+            blobs[i] = get_local_(*k);
+            res[i] = blobs[i]->data();
+            sizes[i] = blobs[i]->size();
+            delete k;
+        }
+
+        // Send back one MultiReply with all of the data, straight from the map
+        MultiReply r(n, res, mg->id(), sizes);
+        exit_if_not(send_msg_(c, r), "Call to send() failed");
+        for (size_t i = 0; i < n; i++) blobs[i]->release();
+        delete[] blobs; delete[] res; delete[] sizes; delete[] mg->keys_; delete mg;
+    }
+
+    /**
+     * Processes the given MemoryQuery message, on one of the worker threads, by replying with
+     * this node's memory usage
+     */
+    void process_memory_query_(MemoryQuery* q, Connection* c) {
+        MemoryUsage* usage = memory_usage();
+        const char* serial = usage->serialize();
+        Reply r(serial, MsgKind::MemoryQuery, q->id());
+        exit_if_not(send_msg_(c, r), "Call to send() failed");
+        delete[] serial; delete usage; delete q;
     }
 
     /**
      * Client function
      * Create a socket to the client at the given IP, connect to it, and send it a Register message.
-     * 
+     *
      * @param ip  The IP address of the other client
      * @param idx The node index of the other client
      */
     void connect_to_client_(char* ip, size_t idx) {
+        exit_if_not(idx < num_nodes_, "Directory contains an invalid node index");
         struct addrinfo* client_info;
         int client_fd;
         // Generate an addrinfo struct for the other client
         memset(&hints_, 0, sizeof(hints_));
         hints_.ai_family = AF_INET;
         hints_.ai_socktype = SOCK_STREAM;
-        exit_if_not(getaddrinfo(ip, PORT, &hints_, &client_info) == 0, 
+        exit_if_not(getaddrinfo(ip, PORT, &hints_, &client_info) == 0,
             "Call to getaddrinfo() failed");
         // Create a socket to connect to the client
-        exit_if_not((client_fd = socket(client_info->ai_family, client_info->ai_socktype, 
+        exit_if_not((client_fd = socket(client_info->ai_family, client_info->ai_socktype,
             client_info->ai_protocol)) >= 0, "Call to socket() failed");
         // Connect to the client
-        exit_if_not(connect(client_fd, client_info->ai_addr, client_info->ai_addrlen) >= 0, 
+        exit_if_not(connect(client_fd, client_info->ai_addr, client_info->ai_addrlen) >= 0,
             "Call to connect() failed");
         freeaddrinfo(client_info);
+        // Start watching the socket
+        Connection* c = add_connection_(client_fd);
         // Send the client a Register message
         Register reg(new String(ip_), idx_);
-        const char* msg = reg.serialize();
-        exit_if_not(send(client_fd, msg, strlen(msg) + 1, 0) > 0, 
-            "Sending Register to other client failed");
-        // Add the fd to the master list
-        FD_SET(client_fd, &master_);
-        // Update the max fd value
-        if (client_fd > fdmax_) {
-            fdmax_ = client_fd;
-        }
-        // Keep track of the client's fd and node index
-        nodes_[idx] = client_fd;
-        delete[] msg;
+        exit_if_not(send_msg_(c, reg), "Sending Register to other client failed");
+        // Keep track of the client's connection and node index
+        nodes_[idx] = c;
     }
 
     /**
-     * Empties the fd/ip map and closes every fd
+     * Closes the socket of every connection to another node.
      */
-    void clear_map_() {
-        for (int i = 0; i < BACKLOG; i++) {
-            int fd = nodes_[i];
-            if (fd != -1) {
-                close(fd);
-                nodes_[i] = -1;
-            }
-        }
+    void close_connections_() {
+        std::lock_guard<std::mutex> lock(conns_mtx_);
+        for (auto& entry : conns_) close(entry.first);
     }
 
     /**
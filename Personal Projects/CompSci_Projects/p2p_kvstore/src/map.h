@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vector.h"
+#include "hashmap.h"
 
 /** Item_ are entries in a Map, they are not exposed, and are immutable.
  *  author: jv */
@@ -16,23 +17,28 @@ public:
     vals_.append(v);
   }
 
+  /** Compares the cached hashes before calling equals(). */
+  bool same_(Object& k, Object* other) {
+    return k.hash() == other->hash() && k.equals(other);
+  }
+
   bool contains_(Object& k) {
     for (int i = 0; i < keys_.size(); i++) 
-      if (k.equals(keys_.get(i)))
+      if (same_(k, keys_.get(i)))
 	      return true;
     return false;
   }
 
   Object* get(Object& k) {
     for (int i = 0; i < keys_.size(); i++) 
-      if (k.equals(keys_.get(i)))
+      if (same_(k, keys_.get(i)))
 	      return vals_.get(i);
     return nullptr;
   }
 
   size_t put(Object& k, Object* v) {
     for (int i = 0; i < keys_.size(); i++) 
-      if (k.equals(keys_.get(i))) {
+      if (same_(k, keys_.get(i))) {
         vals_.set(v, i);
         return 0;
       }
@@ -44,7 +50,7 @@ public:
 
   size_t remove(Object& k) {
     for (int i = 0; i < keys_.size(); i++) 
-      if (k.equals(keys_.get(i))) {
+      if (same_(k, keys_.get(i))) {
         keys_.remove(i);
         vals_.remove(i);
         return 1;
@@ -138,16 +144,8 @@ public:
   Num* clone() { return new Num(v); }
 };
 
-class SIMap : public Map {
+/** A map from Strings to counts.  */
+class SIMap : public HashMap<String, size_t> {
 public:
   SIMap () {}
-  Num* get(String& key) {
-    Num* res = dynamic_cast<Num*>(Map::get(key));
-    assert(res != nullptr);
-    return res;
-  }
-  void put(String& k, Num* v) { 
-    assert(v);
-    Map::put(k, v);
-  }
 }; // SIMap
\ No newline at end of file
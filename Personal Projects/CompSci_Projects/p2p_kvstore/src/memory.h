@@ -0,0 +1,121 @@
+//lang::Cpp
+
+#pragma once
+
+#include <stdio.h>
+#include <atomic>
+
+#include "serial.h"
+
+/** The parts of a node that memory is accounted to. */
+enum class MemKind { StoreValues, StoreIndex, DataFrameCache, NetworkBuffers, PendingMessages };
+
+// The number of MemKinds
+#define MEM_KINDS 5
+
+/**
+ * The number of bytes that each part of one node uses at some point in time:
+ *  - StoreValues: the serialized data in the node's KVStore.
+ *  - StoreIndex: what the KVStore spends on finding that data, its maps' slots and keys and the
+ *    wait_and_get()s parked on keys that have not been put yet.
+ *  - DataFrameCache: the chunks that DistributedVectors on the node hold on to, decoded, fetched
+ *    ahead or waiting to be put.
+ *  - NetworkBuffers: the receive and send buffers of the node's connections.
+ *  - PendingMessages: requests from other nodes that have arrived and are waiting for or being
+ *    processed by a worker, including the MemoryQuery being answered.
+ *
+ * The sizes count the bytes that the data structures allocate, not what the allocator adds on top
+ * of them, so they are a lower bound of what the process uses.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class MemoryUsage : public Object {
+public:
+    size_t bytes_[MEM_KINDS];
+
+    MemoryUsage() {
+        for (size_t i = 0; i < MEM_KINDS; i++) bytes_[i] = 0;
+    }
+
+    /** Returns the number of bytes used by the given part. */
+    size_t get(MemKind k) { return bytes_[(size_t)k]; }
+
+    /** Sets the number of bytes used by the given part. */
+    void set(MemKind k, size_t n) { bytes_[(size_t)k] = n; }
+
+    /** Returns the number of bytes used by all of the parts together. */
+    size_t total() {
+        size_t res = 0;
+        for (size_t i = 0; i < MEM_KINDS; i++) res += bytes_[i];
+        return res;
+    }
+
+    /** Returns the name of the given part. */
+    static const char* name(MemKind k) {
+        switch (k) {
+            case MemKind::StoreValues:     return "store values";
+            case MemKind::StoreIndex:      return "store index";
+            case MemKind::DataFrameCache:  return "dataframe cache";
+            case MemKind::NetworkBuffers:  return "network buffers";
+            case MemKind::PendingMessages: return "pending messages";
+        }
+        return "unknown";
+    }
+
+    /** Prints the usage of every part, one per line, for the node with the given index. */
+    void print(size_t node) {
+        printf("Node %zu memory: %zu bytes\n", node, total());
+        for (size_t i = 0; i < MEM_KINDS; i++) {
+            printf("    %-17s %12zu\n", name((MemKind)i), bytes_[i]);
+        }
+    }
+
+    /** Returns a serialized representation of this usage, the caller owns it. */
+    const char* serialize() {
+        StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /** Writes a serialized representation of this usage to the given sink. */
+    void serialize(Sink& s) {
+        for (size_t i = 0; i < MEM_KINDS; i++) Serializer::write_size_t(s, bytes_[i]);
+    }
+
+    /** Is this usage equal to the given object? */
+    bool equals(Object* other) {
+        MemoryUsage* o = dynamic_cast<MemoryUsage*>(other);
+        if (o == nullptr) return false;
+        for (size_t i = 0; i < MEM_KINDS; i++) {
+            if (bytes_[i] != o->bytes_[i]) return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * Running byte counts for the parts of a node whose memory is not all in one place that can be
+ * walked, such as the chunks cached by every DistributedVector. Whoever allocates memory of a part
+ * add()s its size here and sub()tracts it again when it is freed. Safe to use from any thread.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class MemoryCounters : public Object {
+public:
+    std::atomic<size_t> bytes_[MEM_KINDS];
+
+    MemoryCounters() {
+        for (size_t i = 0; i < MEM_KINDS; i++) bytes_[i] = 0;
+    }
+
+    /** Counts n more bytes for the given part. */
+    void add(MemKind k, size_t n) { bytes_[(size_t)k] += n; }
+
+    /** Counts n fewer bytes for the given part. */
+    void sub(MemKind k, size_t n) { bytes_[(size_t)k] -= n; }
+
+    /** Returns the number of bytes counted for the given part. */
+    size_t get(MemKind k) { return bytes_[(size_t)k]; }
+};
@@ -7,6 +7,7 @@
 #include <arpa/inet.h>
 #include "vector.h"
 #include "key.h"
+#include "frame.h"
 
 /**
  * An enum for the different kinds of messages.
@@ -14,9 +15,11 @@
  * @author Spencer LaChance <lachance.s@northeastern.edu>
  * @author David Mberingabo <mberingabo.d@husky.neu.edu>
  */
-enum class MsgKind { Ack, Put, Reply, Get, WaitAndGet, Register, Directory };
+enum class MsgKind { Ack, Put, Reply, Get, WaitAndGet, Register, Directory, MultiPut, MultiGet,
+    MultiReply, MemoryQuery };
 
 class Ack; class Register; class Directory; class Reply; class Put; class Get; class WaitAndGet;
+class MultiPut; class MultiGet; class MultiReply; class MemoryQuery;
  
 /**
  * An abstract class for messages
@@ -27,6 +30,11 @@ class Ack; class Register; class Directory; class Reply; class Put; class Get; c
 class Message : public Object {
 public:
     MsgKind kind_;  // the message kind
+    // The id of the request that this message belongs to. A response carries the id of the
+    // request it answers so that the sender can match them up.
+    size_t id_;
+
+    Message() : id_(0) { }
     
     /* A method for checking message class equality */
     virtual bool equals(Object* other) {
@@ -38,6 +46,23 @@ public:
     /* Returns this message's kind */
     MsgKind kind() { return kind_; }
 
+    /* Returns the id of the request that this message belongs to */
+    size_t id() { return id_; }
+
+    /* Writes the serialized kind and request id of this message to the given sink */
+    void serialize_header_(Sink& s) {
+        Serializer::write_size_t(s, (size_t)kind_);
+        Serializer::write_size_t(s, id_);
+    }
+
+    /* Writes the given blob of data of the given length to the given sink, preceded by its
+     * serialized length so that the blob may contain any bytes. The blob is borrowed, so that
+     * a Payload sends it from where it is instead of copying it. */
+    static void serialize_blob_(Sink& s, const char* v, size_t len) {
+        Serializer::write_size_t(s, len);
+        s.write_borrowed(v, len);
+    }
+
     /** Type converters: Return same column under its actual type, or
      *  nullptr if of the wrong type.  */
     virtual Ack* as_ack() = 0;
@@ -47,28 +72,43 @@ public:
     virtual Put* as_put() = 0;
     virtual Get* as_get() = 0;
     virtual WaitAndGet* as_wait_and_get() = 0;
+    virtual MultiPut* as_multi_put() = 0;
+    virtual MultiGet* as_multi_get() = 0;
+    virtual MultiReply* as_multi_reply() = 0;
+    virtual MemoryQuery* as_memory_query() = 0;
 };
  
 
 class Ack : public Message {
 public:
     
-    /* Constructor. */
-    Ack() {
+    /* Constructor. The id is that of the Put being acknowledged. */
+    Ack(size_t id = 0) {
         kind_ = MsgKind::Ack;
+        id_ = id;
     }
 
     /* Returns a serialized representation of this acknowledge. */
     const char* serialize() {
         StrBuff buff;
-        // serialize the MsgKind
-        char* serial_kind = Serializer::serialize_size_t((size_t)kind_);
-        buff.c(serial_kind);
-        buff.c("\n");
-        delete[] serial_kind;
+        serialize(buff);
         return buff.c_str();
     }
 
+    /* Writes a serialized representation of this acknowledge to the given sink. */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
+        s.write_str("\n");
+    }
+
+    /* Checks if this ack equals the given object */
+    bool equals(Object* other) {
+        Ack* o = dynamic_cast<Ack*>(other);
+        if (o == nullptr) return false;
+        return o->id() == id_;
+    }
+
     /* Returns this Ack */
     Ack* as_ack() {
         return this;
@@ -103,6 +143,26 @@ public:
     WaitAndGet* as_wait_and_get() {
         return nullptr;
     }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
 };
 
 /**
@@ -141,20 +201,19 @@ public:
     /* Returns a serial representation of this register. */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serial representation of this register to the given sink. */
+    void serialize(Sink& s) {
         // serialize the MsgKind
-        char* serial_kind = Serializer::serialize_size_t((size_t)kind_);
-        buff.c(serial_kind);
-        delete[] serial_kind;
+        Serializer::write_size_t(s, (size_t)kind_);
         // serialize the sender's IP
-        const char* serial_ip = ip_->serialize();
-        buff.c(serial_ip);
-        delete[] serial_ip;
+        ip_->serialize(s);
         // serialize the sender's node index
-        char* serial_sender = Serializer::serialize_size_t(sender_);
-        buff.c(serial_sender);
-        delete[] serial_sender;
-        buff.c("\n");
-        return buff.c_str();
+        Serializer::write_size_t(s, sender_);
+        s.write_str("\n");
     }
 
     /* Returns nullptr because this is not an Ack */
@@ -191,6 +250,26 @@ public:
     WaitAndGet* as_wait_and_get() {
         return nullptr;
     }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
 };
  
 class Directory : public Message {
@@ -248,20 +327,19 @@ public:
     /* Returns a serialized representation of this directory message */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this directory message to the given sink */
+    void serialize(Sink& s) {
         // serialize the MsgKind
-        const char* serial_kind = Serializer::serialize_size_t((size_t)kind_);
-        buff.c(serial_kind);
-        delete[] serial_kind;
+        Serializer::write_size_t(s, (size_t)kind_);
         // serialize IP addresses list
-        const char* serial_vec = addresses_->serialize();
-        buff.c(serial_vec);
-        delete[] serial_vec;
+        addresses_->serialize(s);
         // serialize node indices list
-        const char* serial_ivec = indices_->serialize();
-        buff.c(serial_ivec);
-        delete[] serial_ivec;
-        buff.c("\n");
-        return buff.c_str();
+        indices_->serialize(s);
+        s.write_str("\n");
     }
 
     /**
@@ -308,6 +386,26 @@ public:
     WaitAndGet* as_wait_and_get() {
         return nullptr;
     }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
 };
 
 /* Put is a message subclass used to store a blob of serialized data at a key. */
@@ -315,10 +413,16 @@ class Put : public Message {
 public:
     Key* k_;   // external
     const char* v_; // external
+    // The number of bytes of the value, which may hold any bytes
+    size_t len_;
 
-    /* Constructor */
-    Put(Key* k, const char* v) : k_(k), v_(v) {
+    /* Constructor for a null terminated value */
+    Put(Key* k, const char* v, size_t id = 0) : Put(k, v, strlen(v), id) { }
+
+    /* Constructor for a value of the given length */
+    Put(Key* k, const char* v, size_t len, size_t id) : k_(k), v_(v), len_(len) {
         kind_ = MsgKind::Put;
+        id_ = id;
     }
 
     /* Returns this put message's key */
@@ -327,28 +431,34 @@ public:
     /* Returns this put message's value */
     const char* get_value() { return v_; }
 
+    /* Returns the number of bytes of this put message's value */
+    size_t get_size() { return len_; }
+
     /* Returns a serialized representation of this put message */
     const char* serialize() {
         StrBuff buff;
-        // serialize the MsgKind
-        const char* serial_kind = Serializer::serialize_size_t((size_t)kind_);
-        buff.c(serial_kind);
-        delete[] serial_kind;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this put message to the given sink, lending it the
+     * value rather than copying it */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
         // serialize the key
-        const char* serial_k = k_->serialize();
-        buff.c(serial_k);
-        delete[] serial_k;
+        k_->serialize(s);
         // write the serialized value
-        buff.c(v_);
-        buff.c("\n");
-        return buff.c_str();
+        s.write_borrowed(v_, len_);
+        s.write_str("\n");
     }
 
     /* Return true if this put message equals the given object, and false if not. */
     bool equals(Object* o) {
         Put* other = dynamic_cast<Put*>(o);
         if (other == nullptr) return false;
-        return other->get_key()->equals(k_) && strcmp(v_, other->get_value()) == 0;
+        return other->get_key()->equals(k_) && other->get_size() == len_ &&
+            memcmp(v_, other->get_value(), len_) == 0 && other->id() == id_;
     }
 
     /* Returns nullptr because this is not an Ack */
@@ -385,6 +495,26 @@ public:
     WaitAndGet* as_wait_and_get() {
         return nullptr;
     }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
 };
 
 /**
@@ -395,9 +525,10 @@ public:
     Key* k_;
 
     /* Constructor, takes ownership of the given Key */
-    Get(Key* k) {
+    Get(Key* k, size_t id = 0) {
         kind_ = MsgKind::Get;
         k_ = k;
+        id_ = id;
     }
 
     /* Return this Get message's key */
@@ -408,23 +539,24 @@ public:
     /* Returns a serialized representation of this get message */
     const char* serialize() {
         StrBuff buff;
-        // serialize the MsgKind
-        const char* serial_kind = Serializer::serialize_size_t((size_t)kind_);
-        buff.c(serial_kind);
-        delete[] serial_kind;
-        // serialize the key
-        const char* serialized_k = k_->serialize();
-        buff.c(serialized_k);
-        delete[] serialized_k;
-        buff.c("\n");
+        serialize(buff);
         return buff.c_str();
     }
 
+    /* Writes a serialized representation of this get message to the given sink */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
+        // serialize the key
+        k_->serialize(s);
+        s.write_str("\n");
+    }
+
     /* Return true if this get message equals the given object, and false if not. */
     bool equals(Object* o) {
         Get* other = dynamic_cast<Get*>(o);
         if (other == nullptr) return false;
-        return (other->get_key()->equals(k_));
+        return other->get_key()->equals(k_) && other->id() == id_;
     }
 
     /* Returns nullptr because this is not an Ack */
@@ -461,6 +593,26 @@ public:
     WaitAndGet* as_wait_and_get() {
         return nullptr;
     }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
 };
 
 /**
@@ -471,9 +623,10 @@ public:
     Key* k_;
 
     /* Constructor, takes ownership of the given Key */
-    WaitAndGet(Key* k) {
+    WaitAndGet(Key* k, size_t id = 0) {
         kind_ = MsgKind::WaitAndGet;
         k_ = k;
+        id_ = id;
     }
 
     /* Desrtuctor */
@@ -487,23 +640,24 @@ public:
     /* Returns a serialized representation of this WaitAndGet message */
     const char* serialize() {
         StrBuff buff;
-        // serialize the MsgKind
-        const char* serial_kind = Serializer::serialize_size_t((size_t)kind_);
-        buff.c(serial_kind);
-        delete[] serial_kind;
-        // serialize the key
-        const char* serialized_k = k_->serialize();
-        buff.c(serialized_k);
-        delete[] serialized_k;
-        buff.c("\n");
+        serialize(buff);
         return buff.c_str();
     }
 
+    /* Writes a serialized representation of this WaitAndGet message to the given sink */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
+        // serialize the key
+        k_->serialize(s);
+        s.write_str("\n");
+    }
+
     /* Return true if this get message equals the given object, and false if not. */
     bool equals(Object* o) {
         WaitAndGet* other = dynamic_cast<WaitAndGet*>(o);
         if (other == nullptr) return false;
-        return (other->get_key()->equals(k_));
+        return other->get_key()->equals(k_) && other->id() == id_;
     }
 
     /* Returns nullptr because this is not an Ack */
@@ -540,6 +694,26 @@ public:
     WaitAndGet* as_wait_and_get() {
         return this;
     }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
 };
 
 /**
@@ -548,12 +722,19 @@ public:
 class Reply : public Message {
 public:
     const char* v_; // external
+    // The number of bytes of the value, which may hold any bytes
+    size_t len_;
     // The type of request that this message is a response to (either Get or WaitAndGet)
     MsgKind request_;
 
-    /* Constructor */
-    Reply(const char* v, MsgKind req) : v_(v), request_(req) {
+    /* Constructor for a null terminated value. The id is that of the Get or WaitAndGet being
+     * answered. */
+    Reply(const char* v, MsgKind req, size_t id = 0) : Reply(v, strlen(v), req, id) { }
+
+    /* Constructor for a value of the given length */
+    Reply(const char* v, size_t len, MsgKind req, size_t id) : v_(v), len_(len), request_(req) {
         kind_ = MsgKind::Reply;
+        id_ = id;
     }
 
     /* Return this reply's value */
@@ -561,6 +742,11 @@ public:
         return v_;
     }
 
+    /* Returns the number of bytes of this reply's value */
+    size_t get_size() {
+        return len_;
+    }
+
     /* Return this reply's request_ field */
     MsgKind get_request() {
         return request_;
@@ -569,25 +755,28 @@ public:
     /* Returns a serialized representation of this reply message */
     const char* serialize() {
         StrBuff buff;
-        // serialize the MsgKind
-        const char* serial_kind = Serializer::serialize_size_t((size_t)kind_);
-        buff.c(serial_kind);
-        delete[] serial_kind;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this reply message to the given sink, lending it
+     * the value rather than copying it */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
         // serialize the request MsgKind
-        const char* serial_req = Serializer::serialize_size_t((size_t)request_);
-        buff.c(serial_req);
-        delete[] serial_req;
+        Serializer::write_size_t(s, (size_t)request_);
         // write the serialized value
-        buff.c(v_);
-        buff.c("\n");
-        return buff.c_str();
+        s.write_borrowed(v_, len_);
+        s.write_str("\n");
     }
 
     /* Checks if this reply equals to the given object */
     bool equals(Object* o) {
         Reply* other = dynamic_cast<Reply*>(o);
         if (other == nullptr) return false;
-        return strcmp(v_, other->get_value()) == 0 && other->get_request() == request_;
+        return other->get_size() == len_ && memcmp(v_, other->get_value(), len_) == 0 &&
+            other->get_request() == request_ && other->id() == id_;
     }
 
     /* Returns nullptr because this is not an Ack */
@@ -624,4 +813,465 @@ public:
     WaitAndGet* as_wait_and_get() {
         return nullptr;
     }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
+};
+/**
+ * MultiPut is a Message subclass used to store several blobs of serialized data, each at its own
+ * key, on the same node in one round trip. It is acknowledged with a single Ack.
+ */
+class MultiPut : public Message {
+public:
+    // The number of key/value pairs
+    size_t n_;
+    Key** keys_; // external
+    const char** vals_; // external
+    // The number of bytes of each value, or nullptr if the values are null terminated, external
+    size_t* lens_;
+
+    /* Constructor, the value at index i is to be stored at the key at index i. The values are
+     * null terminated unless their lengths are given. */
+    MultiPut(size_t n, Key** keys, const char** vals, size_t id = 0, size_t* lens = nullptr) :
+        n_(n), keys_(keys), vals_(vals), lens_(lens) {
+        kind_ = MsgKind::MultiPut;
+        id_ = id;
+    }
+
+    /* Returns the number of key/value pairs */
+    size_t size() { return n_; }
+
+    /* Returns the key at the given index */
+    Key* get_key(size_t i) { return keys_[i]; }
+
+    /* Returns the value at the given index */
+    const char* get_value(size_t i) { return vals_[i]; }
+
+    /* Returns the number of bytes of the value at the given index */
+    size_t get_size(size_t i) { return lens_ == nullptr ? strlen(vals_[i]) : lens_[i]; }
+
+    /* Returns a serialized representation of this MultiPut message */
+    const char* serialize() {
+        StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this MultiPut message to the given sink, lending it
+     * the values rather than copying them */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
+        // serialize the number of pairs
+        Serializer::write_size_t(s, n_);
+        // serialize each key followed by its value
+        for (size_t i = 0; i < n_; i++) {
+            keys_[i]->serialize(s);
+            serialize_blob_(s, vals_[i], get_size(i));
+        }
+        s.write_str("\n");
+    }
+
+    /* Return true if this MultiPut message equals the given object, and false if not. */
+    bool equals(Object* o) {
+        MultiPut* other = dynamic_cast<MultiPut*>(o);
+        if (other == nullptr || other->size() != n_ || other->id() != id_) return false;
+        for (size_t i = 0; i < n_; i++) {
+            if (!other->get_key(i)->equals(keys_[i])) return false;
+            size_t len = get_size(i);
+            if (other->get_size(i) != len || memcmp(other->get_value(i), vals_[i], len) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    /* Returns nullptr because this is not a Ack */
+    Ack* as_ack() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Register */
+    Register* as_register() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Directory */
+    Directory* as_directory() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Reply */
+    Reply* as_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Put */
+    Put* as_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Get */
+    Get* as_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a WaitAndGet */
+    WaitAndGet* as_wait_and_get() {
+        return nullptr;
+    }
+
+    /* Returns this MultiPut */
+    MultiPut* as_multi_put() {
+        return this;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
+};
+
+/**
+ * MultiGet is a Message subclass that is used to request the values at several keys that are all
+ * stored on the same node in one round trip. It is answered with a single MultiReply.
+ */
+class MultiGet : public Message {
+public:
+    // The number of keys
+    size_t n_;
+    Key** keys_; // external
+
+    /* Constructor */
+    MultiGet(size_t n, Key** keys, size_t id = 0) : n_(n), keys_(keys) {
+        kind_ = MsgKind::MultiGet;
+        id_ = id;
+    }
+
+    /* Returns the number of keys */
+    size_t size() { return n_; }
+
+    /* Returns the key at the given index */
+    Key* get_key(size_t i) { return keys_[i]; }
+
+    /* Returns a serialized representation of this MultiGet message */
+    const char* serialize() {
+        StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this MultiGet message to the given sink */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
+        // serialize the number of keys
+        Serializer::write_size_t(s, n_);
+        // serialize the keys
+        for (size_t i = 0; i < n_; i++) keys_[i]->serialize(s);
+        s.write_str("\n");
+    }
+
+    /* Return true if this MultiGet message equals the given object, and false if not. */
+    bool equals(Object* o) {
+        MultiGet* other = dynamic_cast<MultiGet*>(o);
+        if (other == nullptr || other->size() != n_ || other->id() != id_) return false;
+        for (size_t i = 0; i < n_; i++) {
+            if (!other->get_key(i)->equals(keys_[i])) return false;
+        }
+        return true;
+    }
+
+    /* Returns nullptr because this is not a Ack */
+    Ack* as_ack() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Register */
+    Register* as_register() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Directory */
+    Directory* as_directory() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Reply */
+    Reply* as_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Put */
+    Put* as_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Get */
+    Get* as_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a WaitAndGet */
+    WaitAndGet* as_wait_and_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns this MultiGet */
+    MultiGet* as_multi_get() {
+        return this;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
+};
+
+/**
+ * MultiReply is a subclass of Message that answers a MultiGet with the value at each of its keys,
+ * in the same order.
+ */
+class MultiReply : public Message {
+public:
+    // The number of values
+    size_t n_;
+    const char** vals_; // external
+    // The number of bytes of each value, or nullptr if the values are null terminated, external
+    size_t* lens_;
+
+    /* Constructor. The id is that of the MultiGet being answered. The values are null
+     * terminated unless their lengths are given. */
+    MultiReply(size_t n, const char** vals, size_t id = 0, size_t* lens = nullptr) : n_(n),
+        vals_(vals), lens_(lens) {
+        kind_ = MsgKind::MultiReply;
+        id_ = id;
+    }
+
+    /* Returns the number of values */
+    size_t size() { return n_; }
+
+    /* Returns the value at the given index */
+    const char* get_value(size_t i) { return vals_[i]; }
+
+    /* Returns the number of bytes of the value at the given index */
+    size_t get_size(size_t i) { return lens_ == nullptr ? strlen(vals_[i]) : lens_[i]; }
+
+    /* Returns the array of values */
+    const char** get_values() { return vals_; }
+
+    /* Returns the array of value lengths, or nullptr if the values are null terminated */
+    size_t* get_sizes() { return lens_; }
+
+    /* Returns a serialized representation of this MultiReply message */
+    const char* serialize() {
+        StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this MultiReply message to the given sink, lending
+     * it the values rather than copying them */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
+        // serialize the number of values
+        Serializer::write_size_t(s, n_);
+        // serialize the values
+        for (size_t i = 0; i < n_; i++) serialize_blob_(s, vals_[i], get_size(i));
+        s.write_str("\n");
+    }
+
+    /* Checks if this MultiReply equals the given object */
+    bool equals(Object* o) {
+        MultiReply* other = dynamic_cast<MultiReply*>(o);
+        if (other == nullptr || other->size() != n_ || other->id() != id_) return false;
+        for (size_t i = 0; i < n_; i++) {
+            size_t len = get_size(i);
+            if (other->get_size(i) != len || memcmp(other->get_value(i), vals_[i], len) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    /* Returns nullptr because this is not a Ack */
+    Ack* as_ack() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Register */
+    Register* as_register() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Directory */
+    Directory* as_directory() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Reply */
+    Reply* as_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Put */
+    Put* as_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Get */
+    Get* as_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a WaitAndGet */
+    WaitAndGet* as_wait_and_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns this MultiReply */
+    MultiReply* as_multi_reply() {
+        return this;
+    }
+
+    /* Returns nullptr because this is not a MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return nullptr;
+    }
+};
+
+/**
+ * MemoryQuery is a subclass of Message that asks a node how much memory each of its parts uses.
+ * It is answered with a Reply holding the node's serialized MemoryUsage.
+ */
+class MemoryQuery : public Message {
+public:
+
+    /* Constructor */
+    MemoryQuery(size_t id = 0) {
+        kind_ = MsgKind::MemoryQuery;
+        id_ = id;
+    }
+
+    /* Returns a serialized representation of this MemoryQuery message */
+    const char* serialize() {
+        StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /* Writes a serialized representation of this MemoryQuery message to the given sink */
+    void serialize(Sink& s) {
+        // serialize the MsgKind and request id
+        serialize_header_(s);
+        s.write_str("\n");
+    }
+
+    /* Checks if this MemoryQuery equals the given object */
+    bool equals(Object* other) {
+        MemoryQuery* o = dynamic_cast<MemoryQuery*>(other);
+        if (o == nullptr) return false;
+        return o->id() == id_;
+    }
+
+    /* Returns nullptr because this is not an Ack */
+    Ack* as_ack() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Register */
+    Register* as_register() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Directory */
+    Directory* as_directory() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Reply */
+    Reply* as_reply() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Put */
+    Put* as_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a Get */
+    Get* as_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a WaitAndGet */
+    WaitAndGet* as_wait_and_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiPut */
+    MultiPut* as_multi_put() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiGet */
+    MultiGet* as_multi_get() {
+        return nullptr;
+    }
+
+    /* Returns nullptr because this is not a MultiReply */
+    MultiReply* as_multi_reply() {
+        return nullptr;
+    }
+
+    /* Returns this MemoryQuery */
+    MemoryQuery* as_memory_query() {
+        return this;
+    }
 };
\ No newline at end of file
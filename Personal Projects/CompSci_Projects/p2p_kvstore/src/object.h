@@ -2,6 +2,8 @@
 #include "helper.h"
 // LANGUAGE: CwC
 
+class Sink;
+
 /** Base class for all objects in the system.
  *  author: vitekj@me.com */
 class Object : public Sys {
@@ -32,4 +34,7 @@ public:
     virtual const char* serialize() { 
         return "{type: object}";
     }
+
+    /** Writes a serialized representation of this object to the given sink. */
+    virtual void serialize(Sink& s);
 }; 
@@ -43,31 +43,72 @@ public:
     void set(size_t col, int val) {
         exit_if_not(col < width(), "Column index out of bounds.");
         exit_if_not(col_types_->get(col) == 'I', "Column index corresponds to the wrong type.");
-        DataType* dt = new DataType();
-        dt->set_int(val);
-        fields_->set(dt, col);
+        empty_field_(col)->set_int(val);
     }
     void set(size_t col, float val) {
         exit_if_not(col < width(), "Column index out of bounds.");
         exit_if_not(col_types_->get(col) == 'F', "Column index corresponds to the wrong type.");
-        DataType* dt = new DataType();
-        dt->set_float(val);
-        fields_->set(dt, col);
+        empty_field_(col)->set_float(val);
     }
     void set(size_t col, bool val) {
         exit_if_not(col < width(), "Column index out of bounds.");
         exit_if_not(col_types_->get(col) == 'B', "Column index corresponds to the wrong type.");
-        DataType* dt = new DataType();
-        dt->set_bool(val);
-        fields_->set(dt, col);
+        empty_field_(col)->set_bool(val);
     }
     /** Acquire ownership of the string. */
     void set(size_t col, String* val) {
         exit_if_not(col < width(), "Column index out of bounds.");
         exit_if_not(col_types_->get(col) == 'S', "Column index corresponds to the wrong type.");
-        DataType* dt = new DataType();
-        dt->set_string(val);
-        fields_->set(dt, col);
+        empty_field_(col)->set_string(val);
+    }
+    /** Sets the given column to the given interned string, which the row does not own. */
+    void set_interned(size_t col, String* val) {
+        exit_if_not(col < width(), "Column index out of bounds.");
+        exit_if_not(col_types_->get(col) == 'S', "Column index corresponds to the wrong type.");
+        empty_field_(col)->set_interned(val);
+    }
+    /** Sets the given column to the value of the given field, such as a field of a Column's
+     *  cached chunk, without copying its string. The string is borrowed, so the row must not be
+     *  read after the field is gone. A missing field gives the default value of the column. */
+    void set_view(size_t col, DataType* val) {
+        exit_if_not(col < width(), "Column index out of bounds.");
+        DataType* dt = empty_field_(col);
+        switch (col_types_->get(col)) {
+            case 'I': dt->set_int(val->get_int()); break;
+            case 'B': dt->set_bool(val->get_bool()); break;
+            case 'F': dt->set_float(val->get_float()); break;
+            case 'S': {
+                String* s = val->get_string();
+                if (val->is_interned()) dt->set_interned(s);
+                else dt->set_borrowed(s);
+                break;
+            }
+            default: exit_if_not(false, "Invalid type found.");
+        }
+    }
+    /** Sets the given column to the given field of the right type. Acquire ownership of it. */
+    void set_field(size_t col, DataType* val) {
+        exit_if_not(col < width(), "Column index out of bounds.");
+        exit_if_not(col_types_->get(col) == val->get_type(),
+            "Column index corresponds to the wrong type.");
+        fields_->set(val, col);
+    }
+    /** Returns the field at the given column emptied to be set again, adding it if the column
+     *  was never set. A row that is filled over and over reuses its fields this way. */
+    DataType* empty_field_(size_t col) {
+        if (col == fields_->size()) {
+            DataType* dt = new DataType();
+            fields_->append(dt);
+            return dt;
+        }
+        DataType* dt = dynamic_cast<DataType*>(fields_->get(col));
+        dt->clear();
+        return dt;
+    }
+    /** Returns the field at the given column, which the row keeps ownership of. */
+    DataType* get_field(size_t col) {
+        exit_if_not(col < width(), "Column index out of bounds.");
+        return dynamic_cast<DataType*>(fields_->get(col));
     }
     
     /** Set/get the index of this row (ie. its position in the dataframe. This is
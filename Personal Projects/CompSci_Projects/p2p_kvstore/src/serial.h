@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include "string.h"
 
 /**
@@ -12,14 +14,56 @@
  */
 class Serializer : public Object {
 public:
+    /** Writes an int to the given sink */
+    static void write_int(Sink& s, int i) {
+        // Negated as an unsigned, so that INT_MIN does not overflow
+        unsigned int u = i < 0 ? 0u - (unsigned int)i : (unsigned int)i;
+        char buf[16];
+        char* start = digits_(buf + sizeof(buf), u);
+        if (i < 0) *--start = '-';
+        *--start = '{';
+        s.write(start, buf + sizeof(buf) - start);
+    }
+
+    /** Writes a size_t to the given sink */
+    static void write_size_t(Sink& s, size_t n) {
+        char buf[24];
+        char* start = digits_(buf + sizeof(buf), n);
+        *--start = '{';
+        s.write(start, buf + sizeof(buf) - start);
+    }
+
+    /** Writes a float to the given sink */
+    static void write_float(Sink& s, float f) {
+        // Large enough for any float printed with 7 decimals
+        char buf[64];
+        int len = snprintf(buf, sizeof(buf), "{%.7f}", f);
+        Sys sys;
+        sys.exit_if_not(len > 0 && len < (int)sizeof(buf), "snprintf failed");
+        s.write(buf, len);
+    }
+
+    /** Writes a bool to the given sink */
+    static void write_bool(Sink& s, bool b) { s.write(b ? "{1}" : "{0}", 3); }
+
+    /** Writes the decimal digits of n followed by a closing brace so that they end right before
+     *  end, and returns where they start. */
+    static char* digits_(char* end, size_t n) {
+        char* p = end;
+        *--p = '}';
+        do {
+            *--p = (char)('0' + n % 10);
+            n /= 10;
+        } while (n != 0);
+        return p;
+    }
+
     /** 
      * Converts an int to a char*
      */
     static char* serialize_int(int i) {
         StrBuff buff;
-        buff.c("{");
-        buff.c(i);
-        buff.c("}");
+        write_int(buff, i);
         return buff.c_str();
     }
 
@@ -28,9 +72,7 @@ public:
      */
     static char* serialize_size_t(size_t n) {
         StrBuff buff;
-        buff.c("{");
-        buff.c(n);
-        buff.c("}");
+        write_size_t(buff, n);
         return buff.c_str();
     }
 
@@ -38,27 +80,8 @@ public:
      * Converts a float to a char*
      */
     static char* serialize_float(float f) {
-        Sys s;
         StrBuff buff;
-        buff.c("{");
-
-        // The size of the buffer that will hold the float
-        size_t len = 10;
-        char* c_float = new char[len]; 
-        int bytes = snprintf(c_float, len, "%.7f", f);
-        s.exit_if_not(bytes >= 0, "snprintf failed");
-        while (bytes >= len) {
-            // The float was too large for the buffer, so increase its size and try again
-            delete[] c_float;
-            len += 10;
-            c_float = new char[len]; 
-            bytes = snprintf(c_float, len, "%.7f", f);
-            s.exit_if_not(bytes >= 0, "snprintf failed");
-        }
-        buff.c(c_float);
-        buff.c("}");
-        
-        delete[] c_float;
+        write_float(buff, f);
         return buff.c_str();
     }
 
@@ -67,23 +90,68 @@ public:
      */
     static char* serialize_bool(bool b) {
         StrBuff buff;
-        buff.c("{");
-        buff.c(b);
-        buff.c("}");
+        write_bool(buff, b);
         return buff.c_str();
     }
+
+    /**
+     * These write numbers into binary formats such as that of a Chunk: the given number is stored
+     * in little-endian byte order at dst, whatever the byte order of this machine. dst need not be
+     * aligned.
+     */
+    static void put_u32(char* dst, uint32_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(dst, &v, 4);
+#else
+        for (size_t i = 0; i < 4; i++) dst[i] = (char)(v >> (8 * i));
+#endif
+    }
+    static void put_u64(char* dst, uint64_t v) {
+        put_u32(dst, (uint32_t)v);
+        put_u32(dst + 4, (uint32_t)(v >> 32));
+    }
+    static void put_float(char* dst, float f) {
+        // The bits are stored as they are, so every float, NaN included, reads back exactly
+        uint32_t bits;
+        memcpy(&bits, &f, 4);
+        put_u32(dst, bits);
+    }
+
+    /** These read back the numbers written by the functions above. */
+    static uint32_t get_u32(const char* src) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        uint32_t v;
+        memcpy(&v, src, 4);
+        return v;
+#else
+        uint32_t v = 0;
+        for (size_t i = 0; i < 4; i++) v |= (uint32_t)(unsigned char)src[i] << (8 * i);
+        return v;
+#endif
+    }
+    static uint64_t get_u64(const char* src) {
+        return get_u32(src) | ((uint64_t)get_u32(src + 4) << 32);
+    }
+    static float get_float(const char* src) {
+        uint32_t bits = get_u32(src);
+        float f;
+        memcpy(&f, &bits, 4);
+        return f;
+    }
 };
 
+/** Writes a serialized representation of this string to the given sink.
+ *  Declared here to avoid circular dependency. */
+void String::serialize(Sink& s) {
+    // serialize the length and the characters
+    Serializer::write_size_t(s, size_);
+    s.write(cstr_, size_);
+}
+
 /** Returns a serialized representation of this string.
  *  Declared here to avoid circular dependency. */
 const char* String::serialize() {
-    // serialize the length and c string value
-    char* serial_len = Serializer::serialize_size_t(size_);
-    // resulting char* needs to be big enough to hold the serialized length, cstr_, and a null
-    // terminator
-    char* res = new char[strlen(serial_len) + size_ + 1];
-    strcpy(res, serial_len);
-    strcat(res, cstr_);
-    delete[] serial_len;
-    return res;
+    StrBuff buff;
+    serialize(buff);
+    return buff.c_str();
 }
\ No newline at end of file
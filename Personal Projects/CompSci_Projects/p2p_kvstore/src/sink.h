@@ -0,0 +1,63 @@
+//lang::Cpp
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include "object.h"
+
+/**
+ * Somewhere that serialized bytes are written to, one piece after the other, such as a growable
+ * buffer (StrBuff), the payload of a frame sent over the network (Payload) or a file (FileSink).
+ * Every serializable type writes itself into a Sink with serialize(Sink&), and writes the objects
+ * it is made of into the same Sink, so the bytes of a nested object are written once, where they
+ * end up, instead of being copied into each of the objects around it.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class Sink : public Object {
+public:
+    /** Writes len bytes of data, which may hold any bytes. The data is only read during the
+     *  call. */
+    virtual void write(const char* data, size_t len) = 0;
+
+    /** Writes len bytes of data that stay valid and unchanged until this sink is done with them,
+     *  such as a large value that is only being sent. A sink may keep a reference to them instead
+     *  of copying them. */
+    virtual void write_borrowed(const char* data, size_t len) { write(data, len); }
+
+    /** Writes the given null terminated string, without its terminator. */
+    void write_str(const char* s) { write(s, strlen(s)); }
+};
+
+/**
+ * A Sink that streams what is written to it into a file as it is produced. Writes are buffered by
+ * the FILE, which must be flushed or closed by its owner.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class FileSink : public Sink {
+public:
+    FILE* f_; // external
+    // The number of bytes written so far
+    size_t size_;
+
+    FileSink(FILE* f) : f_(f), size_(0) { }
+
+    void write(const char* data, size_t len) override {
+        exit_if_not(fwrite(data, 1, len, f_) == len, "Could not write to the file");
+        size_ += len;
+    }
+
+    /** Returns the number of bytes written so far. */
+    size_t size() { return size_; }
+};
+
+/** Writes the serialized representation of a plain Object to the given sink.
+ *  Declared here to avoid circular dependency. */
+inline void Object::serialize(Sink& s) {
+    s.write_str("{type: object}");
+}
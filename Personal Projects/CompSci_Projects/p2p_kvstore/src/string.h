@@ -1,9 +1,11 @@
 #pragma once
 // LANGUAGE: CwC
 #include <cstring>
+#include <stdint.h>
 #include <string>
 #include <cassert>
 #include "object.h"
+#include "sink.h"
 
 /** An immutable string class that wraps a character array.
  * The character array is zero terminated. The size() of the
@@ -20,7 +22,7 @@ public:
     String(char const* cstr, size_t len) {
        size_ = len;
        cstr_ = new char[size_ + 1];
-       memcpy(cstr_, cstr, size_ + 1);
+       memcpy(cstr_, cstr, size_);
        cstr_[size_] = 0; // terminate
     }
     /** Builds a string from a char*, steal must be true, we do not copy!
@@ -37,8 +39,32 @@ public:
     String(String & from):
         Object(from) {
         size_ = from.size_;
-        cstr_ = new char[size_ + 1]; // ensure that we copy the terminator
-        memcpy(cstr_, from.cstr_, size_ + 1);
+        cstr_ = new char[size_ + 1];
+        memcpy(cstr_, from.cstr_, size_);
+        cstr_[size_] = 0; // terminate, from may be a StrView that is not
+    }
+
+    /** Build a string that takes over the characters of another String, which is left empty
+     *  and may only be deleted or assigned to. */
+    String(String && from):
+        Object(from) {
+        size_ = from.size_;
+        cstr_ = from.cstr_;
+        from.size_ = 0;
+        from.cstr_ = nullptr;
+    }
+
+    /** Replaces the characters of this string with those of another String, which is left
+     *  empty and may only be deleted or assigned to. */
+    String& operator=(String && from) {
+        if (&from == this) return *this;
+        delete[] cstr_;
+        size_ = from.size_;
+        cstr_ = from.cstr_;
+        hash_ = from.hash_;
+        from.size_ = 0;
+        from.cstr_ = nullptr;
+        return *this;
     }
 
     /** Delete the string */
@@ -65,6 +91,13 @@ public:
         return strncmp(cstr_, x->cstr_, size_) == 0;
     }
     
+    /** Compare two strings without a dynamic_cast. */
+    bool equals(String* x) {
+        if (x == this) return true;
+        if (x == nullptr || size_ != x->size_) return false;
+        return memcmp(cstr_, x->cstr_, size_) == 0;
+    }
+    
     /** Deep copy of this string */
     String * clone() { return new String(*this); }
 
@@ -75,21 +108,71 @@ public:
         return res;
     }
 
-    /** Compute a hash for this string. */
+    /** Compute a hash for this string. It is cached by hash(), and copied along with the
+     *  string, so it is computed at most once per string. */
     size_t hash_me() override {
-        size_t hash = 0;
-        for (size_t i = 0; i < size_; ++i)
-            hash = cstr_[i] + (hash << 6) + (hash << 16) - hash;
-        return hash;
+        size_t hash = hash_bytes(cstr_, size_);
+        // 0 means "not computed yet" to Object::hash()
+        return hash == 0 ? 1 : hash;
+    }
+
+    /** Hashes len bytes eight at a time. Each word is folded into the hash with a multiply, and
+     *  the result is mixed once more (the MurmurHash3 finalizer) so that every input bit affects
+     *  the low bits that tables index with. */
+    static size_t hash_bytes(const char* s, size_t len) {
+        const uint64_t m = 0x9e3779b97f4a7c15ULL;
+        uint64_t h = len * m;
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
+            memcpy(&w, s + i, 8);
+            h = (h ^ w) * m;
+            h ^= h >> 29;
+        }
+        if (i < len) {
+            // The last 1 to 7 bytes
+            uint64_t w = 0;
+            for (size_t j = 0; i + j < len; j++) w |= (uint64_t)(uint8_t)s[i + j] << (8 * j);
+            h = (h ^ w) * m;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return (size_t)h;
     }
 
     /** Returns a serialized representation of this string */
     const char* serialize();
+
+    /** Writes a serialized representation of this string to the given sink */
+    void serialize(Sink& s);
+
+protected:
+    /** Builds a string without characters, for a subclass to point somewhere. */
+    String() : size_(0), cstr_(nullptr) { }
  };
 
-/** A string buffer builds a string from various pieces.
+/** A String that borrows the characters of something else instead of owning a copy, for looking
+ *  up strings that are not in a String without allocating. The characters need not be null
+ *  terminated, so the view must not be used as a C string, and they must outlive the view and not
+ *  change while it is used. Copying a view with clone() gives an ordinary String. */
+class StrView : public String {
+public:
+    StrView(const char* cstr, size_t len) {
+        cstr_ = (char*)cstr;
+        size_ = len;
+    }
+
+    /** Gives the characters back before ~String() would free them. */
+    ~StrView() { cstr_ = nullptr; }
+};
+
+/** A string buffer builds a string from various pieces. It is also a Sink, so that objects can
+ *  be serialized straight into it.
  *  author: jv */
-class StrBuff : public Object {
+class StrBuff : public Sink {
 public:
     char *val_; // owned; consumed by get()
     size_t capacity_;
@@ -121,7 +204,12 @@ public:
         size_ += step;
         return *this;
     }
-    StrBuff& c(String &s) { return c(s.c_str());  }
+    StrBuff& c(String &s) { return c(s.c_str(), s.size());  }
+    void write(const char* data, size_t len) override {
+        grow_by_(len);
+        memcpy(val_ + size_, data, len);
+        size_ += len;
+    }
     StrBuff& c(size_t v) { return c(std::to_string(v).c_str());  } // Cpp
 
     String* get() {
@@ -0,0 +1,77 @@
+//lang::Cpp
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "string.h"
+#include "hashmap.h"
+
+/**
+ * A table of interned strings. Interning a string returns the one String the pool keeps for its
+ * contents, allocating it only the first time those contents are seen, so a value that repeats
+ * many times, such as a word in a column of words, costs one allocation. Two interned Strings are
+ * equal exactly when they are the same pointer, and each also has a small integer id.
+ *
+ * The pool owns its Strings and they live, unchanged, until the pool is deleted. So they must not
+ * be deleted by their users, and the pool must outlive everything that holds them. Strings are
+ * never removed from a pool, which makes it a fit for values with few distinct contents.
+ *
+ * A pool can be used by several threads at once.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class StringPool : public Object {
+public:
+    // Every interned String mapped to its id. The map owns the Strings.
+    HashMap<String, size_t> ids_;
+    // The interned Strings by id, external
+    std::vector<String*> strings_;
+    // The lock that protects all of the above
+    std::mutex mtx_;
+
+    /** Returns the interned String with the given len bytes as its contents. The bytes need not
+     *  be null terminated. */
+    String* intern(const char* s, size_t len) {
+        // The bytes are hashed before taking the lock
+        StrView probe(s, len);
+        size_t hash = probe.hash();
+        std::lock_guard<std::mutex> lock(mtx_);
+        String* res = ids_.find_key(probe);
+        if (res != nullptr) return res;
+        char* cstr = new char[len + 1];
+        memcpy(cstr, s, len);
+        cstr[len] = '\0';
+        res = new String(true, cstr, len);
+        res->hash_ = hash;
+        ids_.put_owned(res, strings_.size());
+        strings_.push_back(res);
+        return res;
+    }
+
+    /** Returns the interned String with the same contents as the given one. */
+    String* intern(String& s) { return intern(s.c_str(), s.size()); }
+
+    /** Returns the id of the given interned String. Ids are given out in order from 0. */
+    size_t id(String* interned) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        size_t* res = ids_.find(*interned);
+        exit_if_not(res != nullptr && strings_[*res] == interned, "String is not in this pool");
+        return *res;
+    }
+
+    /** Returns the interned String with the given id. */
+    String* get(size_t id) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        exit_if_not(id < strings_.size(), "No String has this id");
+        return strings_[id];
+    }
+
+    /** Returns the number of distinct Strings in the pool. */
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return strings_.size();
+    }
+};
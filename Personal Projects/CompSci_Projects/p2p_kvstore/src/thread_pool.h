@@ -0,0 +1,74 @@
+//lang::Cpp
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+#include "object.h"
+
+/**
+ * A fixed number of worker threads that run tasks taken from a shared queue. Submitting a task
+ * never creates a thread; if every worker is busy the task waits in the queue.
+ *
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class ThreadPool : public Object {
+public:
+    std::vector<std::thread> workers_;
+    // Tasks that have been submitted but not yet picked up by a worker
+    std::deque<std::function<void()>> tasks_;
+    // The lock that protects tasks_ and stopping_
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    // Has the pool been told to finish?
+    bool stopping_;
+
+    /** Starts a pool of the given number of worker threads (at least one). */
+    ThreadPool(size_t threads) : stopping_(false) {
+        if (threads == 0) threads = 1;
+        for (size_t i = 0; i < threads; i++) {
+            workers_.push_back(std::thread(&ThreadPool::run_, this));
+        }
+    }
+
+    /** Runs every task still in the queue and then joins the workers. */
+    ~ThreadPool() {
+        mtx_.lock();
+        stopping_ = true;
+        mtx_.unlock();
+        cv_.notify_all();
+        for (std::thread& th : workers_) th.join();
+    }
+
+    /** Returns the number of worker threads. */
+    size_t size() { return workers_.size(); }
+
+    /** Queues the given task to be run by the next free worker. */
+    void submit(std::function<void()> task) {
+        mtx_.lock();
+        tasks_.push_back(std::move(task));
+        mtx_.unlock();
+        cv_.notify_one();
+    }
+
+    /** The loop run by each worker: take a task, run it, repeat until the pool stops. */
+    void run_() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+};
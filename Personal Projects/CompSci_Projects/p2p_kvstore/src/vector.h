@@ -2,109 +2,62 @@
 
 #include <stdbool.h>
 #include <assert.h>
+#include <algorithm>
+#include <type_traits>
 #include "string.h"
 #include "serial.h"
 
-// The number of chunks held initially in each vector
-#define INITIAL_CHUNK_CAPACITY 1024
-// The number of items that each chunk holds
-#define CHUNK_SIZE 5000
+// The number of elements that a vector holds in itself, before it allocates any memory
+#define VECTOR_INLINE_CAPACITY 4
 
 /**
  * Represents an vector (Java: ArrayList) of objects.
- * In order to have constant time lookup and avoid copying the payload of the 
- * array, this data structure is an array of pointers to chunks of objects. It 
- * is essentially a 2D array. The chunks have a fixed length and when the array 
- * of chunks runs out of space, a new array is allocated with more memory and 
- * the chunk pointers are transferred to it.
+ * The first few elements are kept in a small array inside the vector itself, so
+ * an empty or short vector, such as the fields of a Row, allocates nothing. 
+ * Once that fills up, the elements move to an array on the heap that doubles in 
+ * size whenever it runs out of space.
  * 
  * @author Spencer LaChance <lachance.s@northeastern.edu>
  * @author David Mberingabo <mberingabo.d@husky.neu.edu>
  */
 class Vector : public Object {
 public:
-    Object*** objects_;   
+    // The elements, all owned. Points to inline_ until the vector outgrows it.
+    Object** objects_;
+    Object* inline_[VECTOR_INLINE_CAPACITY];
     int size_;
-    // Number of chunks that we have space for
-    int chunk_capacity_; 
-    // Number of chunks that have been initialized
-    int chunk_count_;
+    // Number of elements that objects_ has space for
+    int capacity_;
 
     /**
      * Initialize an empty Vector.
      */
-    Vector() {
-        size_ = 0;
-        chunk_capacity_ = INITIAL_CHUNK_CAPACITY;
-        chunk_count_ = 1;
-        objects_ = new Object**[chunk_capacity_];
-        objects_[0] = new Object*[CHUNK_SIZE];
-        // Initialize all values in the new chunk to default value nullptr
-        for (int i = 0; i < CHUNK_SIZE; i++) {
-            objects_[0][i] = nullptr;
-        }
-        // Initialize all other chunk uninitialized chunks to default value nullptr
-        for (int i = 1; i < chunk_capacity_; i++) {
-            objects_[i] = nullptr;
-        }
-    }
+    Vector() : objects_(inline_), size_(0), capacity_(VECTOR_INLINE_CAPACITY) { }
 
     /**
      * Destructor for a Vector
      */
     ~Vector() {
-        // Delete each chunk
-        for (int i = 0; i < chunk_capacity_; i++) {
-            if (objects_[i] != nullptr) {
-                // Delete each object in the chunk
-                for (int j = 0; j < CHUNK_SIZE; j++) {
-                    if (objects_[i][j] != nullptr) delete objects_[i][j];
-                }
-                delete[] objects_[i];
-            }
-        }
-        // Delete the array that holds the chunks
-        delete[] objects_;
+        for (int i = 0; i < size_; i++) delete objects_[i];
+        if (objects_ != inline_) delete[] objects_;
     }
 
     /**
-     * Private function that reallocates more space for the vector
-     * once it fills up.
+     * Private function that moves the elements to an array twice as large
+     * once the vector fills up.
      */
     void reallocate_() {
-        Object*** new_outer_arr = new Object**[chunk_capacity_ * 2];
-
-        Object*** old_outer_arr = objects_;
-        for (int i = 0; i < chunk_count_; i++) {
-            new_outer_arr[i] = old_outer_arr[i];
-        }
-        delete[] old_outer_arr;
-        objects_ = new_outer_arr;
-
-        chunk_capacity_ *= 2;
-        // Initialize all other uninitialized chunks to default value nullptr
-        for (int i = chunk_count_; i < chunk_capacity_; i++) {
-            objects_[i] = nullptr;
-        }
+        capacity_ *= 2;
+        Object** new_arr = new Object*[capacity_];
+        memcpy(new_arr, objects_, size_ * sizeof(Object*));
+        if (objects_ != inline_) delete[] objects_;
+        objects_ = new_arr;
     }
     
     // Appends val to the end of the vector. Takes control of the val.
     void append(Object* val) {
-        // If all of the chunks are full, allocate more memory for the outer array.
-        if (size_ + 1 > chunk_capacity_ * CHUNK_SIZE) reallocate_();
-        // If the last chunk is full, initialize a new one and add val to it.
-        if (size_ + 1 > chunk_count_ * CHUNK_SIZE) {
-            objects_[chunk_count_] = new Object*[CHUNK_SIZE];
-            objects_[chunk_count_][0] = val;
-            // Initialize all values in the new chunk to default value nullptr
-            for (int i = 1; i < CHUNK_SIZE; i++) {
-                objects_[chunk_count_][i] = nullptr;
-            }
-            chunk_count_++;
-        } else {
-            objects_[size_ / CHUNK_SIZE][size_ % CHUNK_SIZE] = val;
-        }
-        size_++;
+        if (size_ == capacity_) reallocate_();
+        objects_[size_++] = val;
     }
     
     // Appends a clone of every element of vals to the end of the vector.
@@ -132,31 +85,21 @@ public:
             return;
         }
 
-        int outer_idx = index / CHUNK_SIZE;
-        int inner_idx = index % CHUNK_SIZE;
-        if (delete_val) {
-            // Delete the object at this index if there is one
-            Object* replace_me = dynamic_cast<Object*>(objects_[outer_idx][inner_idx]);
-            if (replace_me != nullptr) delete replace_me;
-        }
-        objects_[outer_idx][inner_idx] = val;
+        if (delete_val) delete objects_[index];
+        objects_[index] = val;
     }
     
     // Gets the element at the given index.
     Object* get(size_t index) {
         assert(index < size_);
-        int outer_idx = index / CHUNK_SIZE;
-        int inner_idx = index % CHUNK_SIZE;
-        return objects_[outer_idx][inner_idx];
+        return objects_[index];
     }
 
-    // Removes the element at the given index.
+    // Removes and deletes the element at the given index, moving the ones after it down by one.
     void remove(size_t index) {
         assert(index < size_);
-        int outer_idx = index / CHUNK_SIZE;
-        int inner_idx = index % CHUNK_SIZE;
-        delete objects_[outer_idx][inner_idx];
-        objects_[outer_idx][inner_idx] = nullptr;
+        delete objects_[index];
+        memmove(objects_ + index, objects_ + index + 1, (size_ - index - 1) * sizeof(Object*));
         size_--;
     }
     
@@ -182,116 +125,106 @@ public:
      */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /**
+     * Writes a serialized version of this Vector to the given sink
+     */
+    void serialize(Sink& s) {
         // serialize the size
-        char* serial_size = Serializer::serialize_size_t(size_);
-        buff.c(serial_size);
-        delete[] serial_size;
+        Serializer::write_size_t(s, size_);
         // serialize the objects
-        for (int i = 0; i < size_; i++) {
-            const char* serial_obj = get(i)->serialize();
-            buff.c(serial_obj);
-            delete[] serial_obj;
-        }
-        return buff.c_str();
+        for (int i = 0; i < size_; i++) get(i)->serialize(s);
     }
 };
 
 /**
- * Represents an vector (Java: ArrayList) of integers.
- * In order to have constant time lookup and avoid copying the payload of the 
- * array, this data structure is an array of pointers to chunks of objects. It 
- * is essentially a 2D array. The chunks have a fixed length and when the array 
- * of chunks runs out of space, a new array is allocated with more memory and 
- * the chunk pointers are transferred to it.
- * 
+ * A vector of plain values of type T, such as ints, doubles, bools or size_ts, stored one after
+ * the other in a single array. Nothing is boxed: appending a value copies it into the array, and
+ * ranges of values can be copied in and out in bulk. Like a Vector, it keeps its first few
+ * elements inside itself and then moves them to an array on the heap that doubles in size
+ * whenever it fills up. A TypedVector can be moved, which hands over its array, but not copied.
+ *
  * @author Spencer LaChance <lachance.s@northeastern.edu>
  * @author David Mberingabo <mberingabo.d@husky.neu.edu>
  */
-class IntVector : public Object {
+template <class T>
+class TypedVector : public Object {
 public:
-    int** ints_;
-    int size_;
-    // Number of chunks that we have space for
-    int chunk_capacity_; 
-    // Number of chunks that have been initialized
-    int chunk_count_;
+    static_assert(std::is_trivial<T>::value, "A TypedVector can only hold plain values");
 
-    /**
-     * Constructor for an IntVector.
-     * 
-    */ 
-    IntVector() {
-        size_ = 0;
-        chunk_capacity_ = INITIAL_CHUNK_CAPACITY;
-        chunk_count_ = 1;
-        ints_ = new int*[chunk_capacity_];
-        ints_[0] = new int[CHUNK_SIZE];
-        // Initialize all other uninitialized chunks to default value nullptr
-        for (int i = 1; i < chunk_capacity_; i++) {
-            ints_[i] = nullptr;
-        }
-    } 
+    // The elements. Points to inline_ until the vector outgrows it.
+    T* vals_;
+    T inline_[VECTOR_INLINE_CAPACITY];
+    size_t size_;
+    // Number of elements that vals_ has space for
+    size_t capacity_;
 
-    /**
-     * Destructor for an IntVector.
-     */ 
-    ~IntVector() {
-        // Delete each chunk
-        for (int i = 0; i < chunk_capacity_; i++) {
-            if (ints_[i] != nullptr) delete[] ints_[i];
-        }
-        // Delete the array that holds the chunks
-        delete[] ints_;
+    /** Initialize an empty TypedVector. */
+    TypedVector() : vals_(inline_), size_(0), capacity_(VECTOR_INLINE_CAPACITY) { }
+
+    /** Takes over the elements of the given vector, which is left empty. */
+    TypedVector(TypedVector&& other) : TypedVector() { take_(other); }
+
+    TypedVector(const TypedVector&) = delete;
+
+    ~TypedVector() {
+        if (vals_ != inline_) delete[] vals_;
     }
 
-    /*
-        * Private function that reallocates more space for the IntVector
-        * once it fills up.
-        */
-    void reallocate_() {
-        int** new_outer_arr = new int*[chunk_capacity_ * 2]; 
+    /** Replaces the elements of this vector with those of the given one, which is left empty. */
+    TypedVector& operator=(TypedVector&& other) {
+        if (this == &other) return *this;
+        if (vals_ != inline_) delete[] vals_;
+        vals_ = inline_;
+        capacity_ = VECTOR_INLINE_CAPACITY;
+        take_(other);
+        return *this;
+    }
 
-        int** old_outer_arr = ints_;
-        for (int i = 0; i < chunk_count_; i++) {
-            new_outer_arr[i] = old_outer_arr[i];
-        }
-        delete[] old_outer_arr;
-        ints_ = new_outer_arr;
+    TypedVector& operator=(const TypedVector&) = delete;
 
-        chunk_capacity_ *= 2;
-        // Initialize all other uninitialized chunks to default value nullptr
-        for (int i = chunk_count_; i < chunk_capacity_; i++) {
-            ints_[i] = nullptr;
-        }
+    /** Makes room for at least n elements in total without growing again. */
+    void reserve(size_t n) {
+        if (n <= capacity_) return;
+        T* new_arr = new T[n];
+        memcpy(new_arr, vals_, size_ * sizeof(T));
+        if (vals_ != inline_) delete[] vals_;
+        vals_ = new_arr;
+        capacity_ = n;
     }
-    
+
     // Appends val onto the end of the vector
-    void append(int val) {
-        // If all of the chunks are full, allocate more memory for the outer array.
-        if (size_ + 1 > chunk_capacity_ * CHUNK_SIZE) reallocate_();
-        // If the last chunk is full, initialize a new one and add val to it.
-        if (size_ + 1 > chunk_count_ * CHUNK_SIZE) {
-            ints_[chunk_count_] = new int[CHUNK_SIZE];
-            ints_[chunk_count_][0] = val;
-            chunk_count_++;
-        } else {
-            ints_[chunk_count_ - 1][size_ % CHUNK_SIZE] = val;
-        }
-        size_++;
+    void append(T val) {
+        if (size_ == capacity_) reserve(capacity_ * 2);
+        vals_[size_++] = val;
     }
-    
+
+    // Appends the n values in vals onto the end of the vector, growing at most once
+    void append_n(const T* vals, size_t n) {
+        if (size_ + n > capacity_) reserve(std::max(size_ + n, capacity_ * 2));
+        memcpy(vals_ + size_, vals, n * sizeof(T));
+        size_ += n;
+    }
+
     // Appends every element of vals to the end of the vector.
     // If vals is null, does nothing.
-    void append_all(IntVector* vals) {
+    void append_all(TypedVector* vals) {
         if (vals == NULL) return;
-        for (int i = 0; i < vals->size(); i++) {
-            append(vals->get(i));
-        }
+        append_n(vals->vals_, vals->size_);
     }
-    
+
+    // Copies the n elements starting at index from into out
+    void copy_out(size_t from, size_t n, T* out) {
+        assert(from + n <= size_);
+        memcpy(out, vals_ + from, n * sizeof(T));
+    }
+
     // Sets the element at index to val.
     // If index == size(), appends to the end of the vector.
-    void set(int val, size_t index) {
+    void set(T val, size_t index) {
         assert(index <= size_);
 
         if (index == size_) {
@@ -299,37 +232,57 @@ public:
             return;
         }
 
-        int outer_idx = index / CHUNK_SIZE;
-        int inner_idx = index % CHUNK_SIZE;
-        ints_[outer_idx][inner_idx] = val;
+        vals_[index] = val;
     }
-    
+
     // Gets the element at index.
-    // If index is >= size(), does nothing and returns undefined.
-    int get(size_t index) {
+    T get(size_t index) {
         assert(index < size_);
-        int outer_idx = index / CHUNK_SIZE;
-        int inner_idx = index % CHUNK_SIZE;
-        return ints_[outer_idx][inner_idx];
+        return vals_[index];
     }
-    
+
+    // Returns the elements as one array, valid until the vector next grows.
+    T* data() { return vals_; }
+
     // Returns the number of elements.
     size_t size() {
         return size_;
     }
 
+    // Removes every element, keeping the memory for reuse.
+    void clear() { size_ = 0; }
+
+    /** Moves the elements of the given vector into this empty one that uses inline_, leaving the
+     *  given vector empty. */
+    void take_(TypedVector& other) {
+        if (other.vals_ == other.inline_) {
+            memcpy(inline_, other.inline_, other.size_ * sizeof(T));
+        } else {
+            vals_ = other.vals_;
+            capacity_ = other.capacity_;
+        }
+        size_ = other.size_;
+        other.vals_ = other.inline_;
+        other.size_ = 0;
+        other.capacity_ = VECTOR_INLINE_CAPACITY;
+    }
+};
+
+/**
+ * Represents an vector (Java: ArrayList) of integers.
+ * 
+ * @author Spencer LaChance <lachance.s@northeastern.edu>
+ * @author David Mberingabo <mberingabo.d@husky.neu.edu>
+ */
+class IntVector : public TypedVector<int> {
+public:
     // Inherited from Object
     // Is this IntVector equal to the given Object?
     bool equals(Object* o) {
         IntVector* other = dynamic_cast<IntVector*>(o);
         if (other == nullptr) return false;
-        if (size_ == 0) return other->size() == 0;
-
-        for (int i = 0; i < size_; i++) {
-            if (!(get(i) == other->get(i))) return false;
-        }
-
-        return true;
+        if (size_ != other->size()) return false;
+        return memcmp(vals_, other->data(), size_ * sizeof(int)) == 0;
     }
 
     /** 
@@ -337,16 +290,17 @@ public:
      */
     const char* serialize() {
         StrBuff buff;
+        serialize(buff);
+        return buff.c_str();
+    }
+
+    /** 
+     * Writes a serialized representation of this int vector to the given sink.
+     */
+    void serialize(Sink& s) {
         // serialize the size
-        char* serial_size = Serializer::serialize_size_t(size_);
-        buff.c(serial_size);
-        delete[] serial_size;
+        Serializer::write_size_t(s, size_);
         // serialize the ints
-        for (int i = 0; i < size_; i++) {
-            char* serial_int = Serializer::serialize_int(get(i));
-            buff.c(serial_int);
-            delete[] serial_int;
-        }
-        return buff.c_str();
+        for (size_t i = 0; i < size_; i++) Serializer::write_int(s, get(i));
     }
 };
\ No newline at end of file
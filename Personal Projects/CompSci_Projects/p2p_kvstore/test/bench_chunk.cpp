@@ -0,0 +1,121 @@
+//lang::Cpp
+
+#include <chrono>
+#include "../src/dataframe.h"
+
+// The number of times each chunk is serialized and deserialized
+#define ROUNDS 50
+
+/**
+ * Compares the text and binary formats of a Chunk, the binary one with its values both raw and
+ * encoded by the best codec. For a full chunk of each type, it serializes and deserializes the
+ * chunk ROUNDS times in each format, checks that the fields come back, and prints the size of the
+ * serialized chunk and how many fields per second each direction handles.
+ * Binary chunks must come back exactly; text chunks round floats, so their floats are only
+ * checked to be close.
+ *
+ * usage: ./chunkbench [-r ROUNDS]
+ */
+
+/** Returns the number of seconds since the given time. */
+double since_(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Returns a full chunk of fields of the given type. */
+Chunk* make_chunk_(char type) {
+    Chunk* c = new Chunk(0);
+    StrBuff buf;
+    for (size_t i = 0; i < CHUNK_SIZE; i++) {
+        DataType* dt = new DataType();
+        switch (type) {
+            case 'I': dt->set_int((int)(i * 7919) - 1000000); break;
+            case 'F': dt->set_float(i * 1.37f - 2000.0f); break;
+            case 'B': dt->set_bool(i % 3 == 0); break;
+            case 'S': dt->set_string(buf.c("word-").c(i % 977).get()); break;
+        }
+        c->append(dt);
+    }
+    return c;
+}
+
+/** Returns true if the fields of the two chunks are equal, or close for text floats. */
+bool same_(Chunk* a, Chunk* b, bool exact) {
+    if (a->size() != b->size()) return false;
+    for (size_t i = 0; i < a->size(); i++) {
+        DataType* x = a->get(i);
+        DataType* y = b->get(i);
+        if (!exact && x->get_type() == 'F') {
+            float d = x->get_float() - y->get_float();
+            if (d > 1e-3f || d < -1e-3f) return false;
+        } else if (!x->equals(y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Prints one line of results. */
+void report_(char type, const char* format, size_t bytes, double ser_secs, double de_secs,
+    size_t rounds) {
+    double fields = (double)CHUNK_SIZE * rounds;
+    printf("%c %-6s %8zu bytes, serialize %6.1fM fields/s (%7.1f MB/s), "
+        "deserialize %6.1fM fields/s (%7.1f MB/s)\n", type, format, bytes, fields / ser_secs / 1e6,
+        bytes * rounds / ser_secs / 1e6, fields / de_secs / 1e6, bytes * rounds / de_secs / 1e6);
+}
+
+/** Measures the text format on the given chunk. */
+void bench_text_(char type, Chunk* c, size_t rounds) {
+    double ser_secs = 0, de_secs = 0;
+    size_t bytes = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        auto start = std::chrono::steady_clock::now();
+        const char* serial = c->serialize();
+        ser_secs += since_(start);
+        bytes = strlen(serial);
+        start = std::chrono::steady_clock::now();
+        Deserializer ds(serial, bytes);
+        Chunk* res = ds.deserialize_chunk();
+        de_secs += since_(start);
+        assert(same_(c, res, false));
+        delete res;
+        delete[] serial;
+    }
+    report_(type, "text", bytes, ser_secs, de_secs, rounds);
+}
+
+/** Measures the binary format on the given chunk, with its values encoded or raw. */
+void bench_binary_(char type, Chunk* c, size_t rounds, bool encode) {
+    double ser_secs = 0, de_secs = 0;
+    size_t bytes = 0;
+    for (size_t r = 0; r < rounds; r++) {
+        auto start = std::chrono::steady_clock::now();
+        const char* serial = c->serialize_binary(bytes, encode);
+        ser_secs += since_(start);
+        start = std::chrono::steady_clock::now();
+        Deserializer ds(serial, bytes);
+        Chunk* res = ds.deserialize_chunk();
+        de_secs += since_(start);
+        assert(same_(c, res, true));
+        delete res;
+        delete[] serial;
+    }
+    report_(type, encode ? "binary" : "raw", bytes, ser_secs, de_secs, rounds);
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = ROUNDS;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-r") == 0) rounds = atoi(argv[i + 1]);
+    }
+
+    const char types[] = { 'I', 'F', 'B', 'S' };
+    for (char type : types) {
+        Chunk* c = make_chunk_(type);
+        bench_text_(type, c, rounds);
+        bench_binary_(type, c, rounds, false);
+        bench_binary_(type, c, rounds, true);
+        delete c;
+    }
+    return 0;
+}
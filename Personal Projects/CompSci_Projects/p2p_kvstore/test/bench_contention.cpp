@@ -0,0 +1,96 @@
+//lang::Cpp
+
+#include <chrono>
+#include "../src/kvstore.h"
+
+// The number of keys that the readers read
+#define NKEYS 1000
+// The number of reads done by each reader thread
+#define NREADS 200000
+// The size of each value in bytes
+#define VAL_SIZE 1000
+
+/**
+ * Measures how local reads of a single KVStore scale with the number of reader threads while one
+ * writer thread keeps putting new keys, which makes the store's maps grow. Every thread works on
+ * the same node (node 0 of a one node system), so this only exercises the store's locking.
+ * Compile with -DSTORE_SHARDS=1 to compare against a store with a single lock.
+ *
+ * usage: ./contention [-r READERS] [-n READS]
+ */
+
+/** Returns a freshly allocated value of VAL_SIZE bytes, the KVStore takes ownership of it. */
+char* make_value_(size_t i) {
+    char* v = new char[VAL_SIZE + 1];
+    memset(v, 'a' + (i % 26), VAL_SIZE);
+    v[VAL_SIZE] = '\0';
+    return v;
+}
+
+/** Returns the key with the given prefix and number, homed on node 0. */
+Key* make_key_(const char* prefix, size_t i) {
+    StrBuff name;
+    char* s = name.c(prefix).c(i).c_str();
+    Key* k = new Key(s, 0);
+    delete[] s;
+    return k;
+}
+
+/** Reads nreads of the preloaded keys, checking each value. */
+void read_(KVStore* kv, Key** keys, size_t nreads, size_t seed) {
+    for (size_t i = 0; i < nreads; i++) {
+        size_t n = (seed * 7919 + i * 104729) % NKEYS;
+        Blob* b = kv->get_blob(*keys[n]);
+        assert(b->size() == VAL_SIZE && b->data()[0] == 'a' + (char)(n % 26));
+        b->release();
+    }
+}
+
+/** Puts new keys until told to stop. */
+void write_(KVStore* kv, std::atomic<bool>* stop, size_t* written) {
+    size_t i = 0;
+    while (!*stop) {
+        Key* k = make_key_("write-", i);
+        kv->put(*k, make_value_(i));
+        delete k;
+        i++;
+    }
+    *written = i;
+}
+
+int main(int argc, char** argv) {
+    size_t nreaders = 4;
+    size_t nreads = NREADS;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-r") == 0) nreaders = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-n") == 0) nreads = atoi(argv[i + 1]);
+    }
+
+    KVStore* kv = new KVStore(0, 1);
+    Key** keys = new Key*[NKEYS];
+    for (size_t i = 0; i < NKEYS; i++) {
+        keys[i] = make_key_("read-", i);
+        kv->put(*keys[i], make_value_(i));
+    }
+
+    std::atomic<bool> stop(false);
+    size_t written = 0;
+    std::thread writer(write_, kv, &stop, &written);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < nreaders; t++) readers.push_back(std::thread(read_, kv, keys, nreads, t));
+    for (std::thread& th : readers) th.join();
+    auto end = std::chrono::steady_clock::now();
+    stop = true;
+    writer.join();
+
+    double secs = std::chrono::duration<double>(end - start).count();
+    printf("%d shard(s), %zu reader(s): %.0f reads/s, %.0f writes/s\n", STORE_SHARDS, nreaders,
+        nreaders * nreads / secs, written / secs);
+
+    for (size_t i = 0; i < NKEYS; i++) delete keys[i];
+    delete[] keys;
+    kv->shutdown();
+    delete kv;
+    return 0;
+}
@@ -0,0 +1,95 @@
+//lang::Cpp
+
+#include <chrono>
+#include <vector>
+#include <unordered_set>
+#include "../src/serial.h"
+#include "../src/key.h"
+
+// The number of times every word is hashed when measuring throughput
+#define ROUNDS 200
+// The number of generated chunk keys
+#define NKEYS 100000
+
+/**
+ * Compares the old byte-at-a-time String hash with the current one on the words of a file and on
+ * keys shaped like the chunk keys of a DistributedVector. For each set of strings it reports how
+ * many distinct strings share a full hash, how many share a slot in a power-of-two table with
+ * one slot per string (what a HashMap or Map indexes with), and how many bytes per second each
+ * hash gets through.
+ *
+ * usage: ./hashbench [-f FILE]
+ */
+
+/** The String hash this repo used before: one byte at a time, shift and add. */
+size_t old_hash_(const char* s, size_t len) {
+    size_t hash = 0;
+    for (size_t i = 0; i < len; ++i) hash = s[i] + (hash << 6) + (hash << 16) - hash;
+    return hash;
+}
+
+/** Returns the words of the given file, each one once. */
+std::vector<std::string> read_words_(const char* file) {
+    std::vector<std::string> words;
+    std::unordered_set<std::string> seen;
+    FILE* f = fopen(file, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "Cannot open file %s\n", file);
+        exit(1);
+    }
+    char buf[1024];
+    while (fscanf(f, "%1023s", buf) == 1) {
+        if (seen.insert(buf).second) words.push_back(buf);
+    }
+    fclose(f);
+    return words;
+}
+
+/** Reports collisions and throughput of the given hash function on the given strings. */
+void measure_(const char* name, const char* set, std::vector<std::string>& strs,
+        size_t (*hash)(const char*, size_t)) {
+    size_t mask = 1;
+    while (mask < strs.size()) mask <<= 1;
+    mask -= 1;
+    std::unordered_set<size_t> full;
+    std::unordered_set<size_t> slots;
+    size_t bytes = 0;
+    for (std::string& s : strs) {
+        size_t h = hash(s.c_str(), s.size());
+        full.insert(h);
+        slots.insert(h & mask);
+        bytes += s.size();
+    }
+
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        for (std::string& s : strs) sink += hash(s.c_str(), s.size());
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-4s %-11s %6zu strings: %4zu full collisions, %6zu slot collisions (%zu slots), "
+        "%7.0f MB/s  (%zx)\n", name, set, strs.size(), strs.size() - full.size(),
+        strs.size() - slots.size(), mask + 1, bytes * ROUNDS / secs / 1e6, sink & 0xf);
+}
+
+int main(int argc, char** argv) {
+    const char* file = "data/100k.txt";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-f") == 0) file = argv[i + 1];
+    }
+
+    std::vector<std::string> words = read_words_(file);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < NKEYS; i++) keys.push_back("data-c-" + std::to_string(i));
+
+    measure_("old", "file words", words, old_hash_);
+    measure_("new", "file words", words, String::hash_bytes);
+    measure_("old", "chunk keys", keys, old_hash_);
+    measure_("new", "chunk keys", keys, String::hash_bytes);
+
+    // Keys with the same string on different nodes must not collide
+    Key a("data", 0);
+    Key b("data", 1);
+    printf("Key hashes differ by home node: %s\n", a.hash() != b.hash() ? "yes" : "NO");
+    return 0;
+}
@@ -0,0 +1,131 @@
+//lang::Cpp
+
+#include <chrono>
+#include <algorithm>
+#include "../src/kvstore.h"
+
+// The number of remote operations that are timed per thread
+#define NOPS 20
+// The size of each value in bytes, roughly that of a serialized chunk of 5000 floats
+#define VAL_SIZE 60000
+
+/**
+ * Measures the latency distribution of remote put() and get() calls. Two KVStores run in this
+ * process (nodes 0 and 1 on 127.0.0.1 and 127.0.0.2), and node 1 repeatedly puts and gets keys
+ * that are homed on node 0. With -t, several application threads on node 1 do so at the same
+ * time, so their requests are in flight together over the same socket.
+ *
+ * It also measures how long a remote wait_and_get() takes to return after the key it is waiting on
+ * is put on node 0.
+ *
+ * usage: ./latency [-n NOPS] [-t THREADS]
+ */
+
+/** Returns a freshly allocated value of VAL_SIZE bytes, the KVStore takes ownership of it. */
+char* make_value_(size_t i) {
+    char* v = new char[VAL_SIZE + 1];
+    memset(v, 'a' + (i % 26), VAL_SIZE);
+    v[VAL_SIZE] = '\0';
+    return v;
+}
+
+/** Sorts the given latencies (in microseconds) and prints their distribution. */
+void report_(const char* name, std::vector<double>& lat) {
+    std::sort(lat.begin(), lat.end());
+    size_t n = lat.size();
+    printf("%-4s n=%zu  min=%.0fus  p50=%.0fus  p90=%.0fus  p99=%.0fus  max=%.0fus\n", name, n,
+        lat[0], lat[n / 2], lat[n * 9 / 10], lat[std::min(n - 1, n * 99 / 100)], lat[n - 1]);
+}
+
+/**
+ * Puts and then gets nops keys through the given KVStore, verifying that every get returns the
+ * value that was put at its key. Appends the latencies to the given vectors.
+ */
+void run_ops_(KVStore* kv, size_t thread, size_t nops, std::vector<double>* put_lat,
+    std::vector<double>* get_lat) {
+    StrBuff name;
+    for (size_t i = 0; i < nops; i++) {
+        char* s = name.c("bench-").c(thread).c("-").c(i).c_str();
+        Key k(s, 0);
+        delete[] s;
+        size_t val = thread * nops + i;
+
+        auto start = std::chrono::steady_clock::now();
+        kv->put(k, make_value_(val));
+        auto mid = std::chrono::steady_clock::now();
+        const char* v = kv->get(k);
+        auto end = std::chrono::steady_clock::now();
+
+        assert(strlen(v) == VAL_SIZE && v[0] == 'a' + (char)(val % 26));
+        delete[] v;
+        put_lat->push_back(std::chrono::duration<double, std::micro>(mid - start).count());
+        get_lat->push_back(std::chrono::duration<double, std::micro>(end - mid).count());
+    }
+}
+
+/**
+ * Has node 1 wait_and_get() nops keys homed on node 0 that node 0 puts a little later, and
+ * appends the time from each put to the waiting get returning to the given vector.
+ */
+void run_wag_(KVStore* server, KVStore* client, size_t nops, std::vector<double>* wag_lat) {
+    StrBuff name;
+    for (size_t i = 0; i < nops; i++) {
+        char* s = name.c("bench-wag-").c(i).c_str();
+        Key k(s, 0);
+        delete[] s;
+        std::chrono::steady_clock::time_point put_time;
+        std::thread producer([&] {
+            // Give the WaitAndGet time to arrive before the key exists
+            usleep(2000);
+            put_time = std::chrono::steady_clock::now();
+            server->put(k, make_value_(i));
+        });
+        const char* v = client->wait_and_get(k);
+        auto end = std::chrono::steady_clock::now();
+        producer.join();
+
+        assert(strlen(v) == VAL_SIZE && v[0] == 'a' + (char)(i % 26));
+        delete[] v;
+        wag_lat->push_back(std::chrono::duration<double, std::micro>(end - put_time).count());
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t nops = NOPS;
+    size_t nthreads = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-n") == 0) nops = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-t") == 0) nthreads = atoi(argv[i + 1]);
+    }
+
+    KVStore* server = new KVStore(0, 2);
+    KVStore* client = new KVStore(1, 2);
+
+    std::vector<std::vector<double>> put_lat(nthreads);
+    std::vector<std::vector<double>> get_lat(nthreads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < nthreads; t++)
+        threads.push_back(std::thread(run_ops_, client, t, nops, &put_lat[t], &get_lat[t]));
+    for (std::thread& th : threads) th.join();
+
+    std::vector<double> all_put;
+    std::vector<double> all_get;
+    for (size_t t = 0; t < nthreads; t++) {
+        all_put.insert(all_put.end(), put_lat[t].begin(), put_lat[t].end());
+        all_get.insert(all_get.end(), get_lat[t].begin(), get_lat[t].end());
+    }
+    printf("%zu thread(s)\n", nthreads);
+    report_("put", all_put);
+    report_("get", all_get);
+
+    std::vector<double> wag_lat;
+    run_wag_(server, client, nops, &wag_lat);
+    report_("wag", wag_lat);
+
+    // Shutting down the client closes its sockets, which makes the server shut itself down
+    client->shutdown();
+    while (!server->has_shutdown) usleep(1000);
+    delete client;
+    delete server;
+    return 0;
+}
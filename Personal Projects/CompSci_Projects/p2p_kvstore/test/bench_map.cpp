@@ -0,0 +1,121 @@
+//lang::Cpp
+
+#include <chrono>
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include "../src/map.h"
+
+// The number of keys put in each map
+#define NKEYS 1000
+// The number of times every key is looked up
+#define ROUNDS 20
+
+/**
+ * Compares the memory use and speed of Map and HashMap on the same String keys, by putting NKEYS
+ * keys in each map and then getting every key ROUNDS times. Memory is counted by replacing the
+ * global operator new and delete, so it includes every allocation the map makes, keys included,
+ * plus the HashMap's slot arrays, which do not go through operator new.
+ * The slowest single put() is reported too, since that is the one that has to grow the map.
+ *
+ * usage: ./mapbench [-n KEYS]
+ */
+
+// The number of bytes currently allocated through operator new
+size_t live_bytes = 0;
+
+void* operator new(size_t size) {
+    // Keep the size in front of the block so that delete can subtract it
+    size_t* p = (size_t*)malloc(size + sizeof(size_t));
+    if (p == nullptr) throw std::bad_alloc();
+    *p = size;
+    live_bytes += size;
+    return p + 1;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+    size_t* p = (size_t*)ptr - 1;
+    live_bytes -= *p;
+    free(p);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+
+/** Returns the number of seconds since the given time. */
+double since_(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Prints one line of results. */
+void report_(const char* name, size_t n, size_t bytes, double put_secs, double max_put_secs,
+    double get_secs) {
+    printf("%-8s %zu keys: %10zu bytes (%6zu per key), %9.0f puts/s (max %7.0fus), "
+        "%10.0f gets/s\n", name, n, bytes, bytes / n, n / put_secs, max_put_secs * 1e6,
+        n * ROUNDS / get_secs);
+}
+
+/** Measures Map, with Strings as values. */
+void bench_map_(String** keys, size_t n) {
+    size_t before = live_bytes;
+    auto start = std::chrono::steady_clock::now();
+    Map* map = new Map();
+    double max_put_secs = 0;
+    for (size_t i = 0; i < n; i++) {
+        auto put_start = std::chrono::steady_clock::now();
+        map->put(*keys[i], new String("v"));
+        max_put_secs = std::max(max_put_secs, since_(put_start));
+    }
+    double put_secs = since_(start);
+    size_t bytes = live_bytes - before;
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < n; i++) assert(map->get(*keys[i]) != nullptr);
+    }
+    double get_secs = since_(start);
+    delete map;
+    report_("Map", n, bytes, put_secs, max_put_secs, get_secs);
+}
+
+/** Measures HashMap, with counts as values. */
+void bench_hashmap_(String** keys, size_t n) {
+    size_t before = live_bytes;
+    auto start = std::chrono::steady_clock::now();
+    HashMap<String, size_t>* map = new HashMap<String, size_t>();
+    double max_put_secs = 0;
+    for (size_t i = 0; i < n; i++) {
+        auto put_start = std::chrono::steady_clock::now();
+        map->put(*keys[i], i + 1);
+        max_put_secs = std::max(max_put_secs, since_(put_start));
+    }
+    double put_secs = since_(start);
+    // The slot arrays are calloc()ed, so operator new does not see them
+    size_t bytes = live_bytes - before + map->capacity() * sizeof(HashMap<String, size_t>::Slot);
+    start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < ROUNDS; r++) {
+        for (size_t i = 0; i < n; i++) assert(map->get(*keys[i]) == i + 1);
+    }
+    double get_secs = since_(start);
+    delete map;
+    report_("HashMap", n, bytes, put_secs, max_put_secs, get_secs);
+}
+
+int main(int argc, char** argv) {
+    size_t n = NKEYS;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-n") == 0) n = atoi(argv[i + 1]);
+    }
+
+    String** keys = new String*[n];
+    StrBuff buf;
+    for (size_t i = 0; i < n; i++) keys[i] = buf.c("word-").c(i).get();
+
+    bench_map_(keys, n);
+    bench_hashmap_(keys, n);
+
+    for (size_t i = 0; i < n; i++) delete keys[i];
+    delete[] keys;
+    return 0;
+}
@@ -233,15 +233,28 @@ void test_rows_cols(DataFrame* df, KVStore* kv, Key* k) {
     df->fill_row(0, *r3);
 
     assert(df->get_int(0, 0) == r3->get_int(0));
+    // Strings are read in place, so the row and the dataframe share the column's string
     String* df_str = df->get_string(1, 0);
     assert(df_str->equals(r3->get_string(1)));
+    assert(df_str == r3->get_string(1));
     assert(df->get_float(2, 0) == r3->get_float(2));
     assert(df->get_bool(3, 0) == r3->get_bool(3));
-    
+
+    // Refilling a row reuses its fields, and adding it copies the borrowed string
+    DataType* field = r3->get_field(1);
+    df->fill_row(1, *r3);
+    assert(r3->get_field(1) == field);
+    assert(r3->get_string(1) == df->get_string(1, 1));
+    Key copy_key("copy", 0);
+    DataFrame* copy = new DataFrame(df->get_schema(), kv, &copy_key);
+    copy->add_row(*r3, true);
+    assert(copy->get_string(1, 0) != r3->get_string(1));
+    assert(copy->get_string(1, 0)->equals(r3->get_string(1)));
+    delete copy;
+
     delete r1;
     delete r2;
     delete r3;
-    delete df_str;
     printf("Rows and columns test passed\n");
 }
 
@@ -265,9 +278,10 @@ int main(int argc, const char** argv) {
     test_datafile(argc, argv, kv);
 
     kv->shutdown();
+    // DataFrames must be deleted before the store they read from
+    delete df;
     delete kv;
     delete k1;
-    delete df;
     delete str;
     return 0;
 }
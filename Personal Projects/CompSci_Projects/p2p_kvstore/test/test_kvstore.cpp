@@ -169,11 +169,64 @@ int main(int argc, char** argv) {
     assert(strcmp(serial_df_strings1, serial_df_strings2) == 0);
     delete[] serial_df_strings1; delete[] serial_df_strings2;
 
+    /* Testing get_blob() method in KVStore: local reads share the stored data. */
+    Blob* blob_f1 = kv_->get_blob(key1);
+    Blob* blob_f2 = kv_->get_blob(key1);
+    const char* serial_blob_f = df_f->serialize();
+    assert(blob_f1 == blob_f2);
+    assert(blob_f1->size() == strlen(serial_blob_f));
+    assert(strcmp(blob_f1->data(), serial_blob_f) == 0);
+    blob_f1->release(); blob_f2->release(); delete[] serial_blob_f;
+
+    /* Testing get() and wait_and_get() of binary data on its home node: the whole value comes
+     * back with its size, NUL bytes included, as it does from another node. */
+    Key bin_key("binary", 0);
+    Key late_key("binary later", 0);
+    const char bin[] = "a\0b\0c";
+    size_t bin_size = sizeof(bin) - 1;
+    char* bin_val = new char[bin_size + 1];
+    memcpy(bin_val, bin, bin_size + 1);
+    kv_->put(bin_key, bin_val, bin_size);
+    size_t got_size = 0;
+    const char* got = kv_->get(bin_key, got_size);
+    assert(got_size == bin_size && memcmp(got, bin, bin_size + 1) == 0);
+    delete[] got;
+    got = kv_->wait_and_get(bin_key, got_size);
+    assert(got_size == bin_size && memcmp(got, bin, bin_size + 1) == 0);
+    delete[] got;
+    std::thread late([&] {
+        char* late_val = new char[bin_size + 1];
+        memcpy(late_val, bin, bin_size + 1);
+        kv_->put(late_key, late_val, bin_size);
+    });
+    got = kv_->wait_and_get(late_key, got_size);
+    late.join();
+    assert(got_size == bin_size && memcmp(got, bin, bin_size + 1) == 0);
+    delete[] got;
+
+    /* Testing memory accounting: the stored frames are counted, and a chunk cached by a read
+     * is counted until the frame holding it is deleted. */
+    MemoryUsage* usage = kv_->memory_usage();
+    assert(usage->get(MemKind::StoreValues) > NROWS * sizeof(int));
+    assert(usage->get(MemKind::StoreIndex) > 0);
+    assert(usage->get(MemKind::PendingMessages) == 0);
+    size_t cached = usage->get(MemKind::DataFrameCache);
+    delete usage;
+    DataFrame* read_ints = kd_->get(key7);
+    assert(read_ints->get_int(0, 1) == ints[1]);
+    usage = kv_->memory_usage(0);
+    assert(usage->get(MemKind::DataFrameCache) > cached);
+    delete usage;
+    delete read_ints;
+    usage = kv_->memory_usage();
+    assert(usage->get(MemKind::DataFrameCache) == cached);
+    delete usage;
+
     kd_->done();
-    delete kd_;
+    // DataFrames must be deleted before the store they read from
     delete df_f; delete df_i; delete df_b; delete df_s; 
     delete df_floats; delete df_bools; delete df_ints; delete df_strings;
-    delete s_;
+    delete kd_;
 
     Sys sys;
     s.pln("kvstore test was SUCCESSFUL");
@@ -1,6 +1,180 @@
 #include "../src/map.h"
+#include "../src/count_map.h"
 #include <assert.h>
 
+/** Tests the open-addressing HashMap, including growing and removing in the middle of probe runs. */
+void test_hashmap() {
+    HashMap<String, size_t> map;
+    String k("key");
+    assert(!map.contains(k));
+    assert(map.get(k) == 0);
+    assert(map.find(k) == nullptr);
+    map.put(k, 7);
+    assert(map.contains(k) && map.get(k) == 7 && map.size() == 1);
+    map.at(k)++;
+    assert(map.get(k) == 8 && map.size() == 1);
+
+    // Enough keys to make the map grow several times
+    size_t n = 5000;
+    StrBuff buf;
+    for (size_t i = 0; i < n; i++) {
+        String* s = buf.c("k").c(i).get();
+        map.put(*s, i);
+        delete s;
+    }
+    assert(map.size() == n + 1);
+    assert(map.capacity() * HASHMAP_LOAD_NUM >= map.size() * HASHMAP_LOAD_DEN);
+    // Remove every other key, then check that every remaining key can still be found
+    for (size_t i = 0; i < n; i += 2) {
+        String* s = buf.c("k").c(i).get();
+        assert(map.erase(*s));
+        assert(!map.erase(*s));
+        delete s;
+    }
+    assert(map.size() == n / 2 + 1);
+    for (size_t i = 0; i < n; i++) {
+        String* s = buf.c("k").c(i).get();
+        if (i % 2 == 0) assert(!map.contains(*s));
+        else assert(map.get(*s) == i);
+        delete s;
+    }
+    // Walking the slots visits every entry once
+    size_t seen = 0;
+    for (size_t i = 0; i < map.capacity(); i++) {
+        if (map.key_at(i) != nullptr) seen++;
+    }
+    assert(seen == map.size());
+    printf("HashMap tests passed.\n");
+}
+
+/** Tests that a HashMap that is in the middle of growing finds, updates, removes and walks its
+ *  entries whichever of its two arrays they are in. */
+void test_hashmap_growing() {
+    HashMap<String, size_t> map;
+    StrBuff buf;
+    size_t n = 0;
+    while (n < 1000 || !map.growing()) {
+        String* s = buf.c("g").c(n).get();
+        map.put(*s, n);
+        delete s;
+        n++;
+    }
+    // The first put after growing started moved only a few slots, so most entries are still old
+    for (size_t i = 0; i < n; i++) {
+        String* s = buf.c("g").c(i).get();
+        assert(map.get(*s) == i);
+        assert(map.find_key(*s) != nullptr && map.find_key(*s)->equals(s));
+        delete s;
+    }
+    size_t seen = 0;
+    for (size_t i = 0; i < map.capacity(); i++) {
+        if (map.key_at(i) != nullptr) seen++;
+    }
+    assert(seen == n);
+    // Remove and update keys while the entries are being moved
+    for (size_t i = 0; i < n; i += 3) {
+        String* s = buf.c("g").c(i).get();
+        assert(map.erase(*s));
+        assert(!map.contains(*s));
+        delete s;
+    }
+    for (size_t i = 1; i < n; i += 3) {
+        String* s = buf.c("g").c(i).get();
+        map.at(*s) += 1000;
+        delete s;
+    }
+    assert(!map.growing());
+    for (size_t i = 0; i < n; i++) {
+        String* s = buf.c("g").c(i).get();
+        if (i % 3 == 0) assert(!map.contains(*s));
+        else if (i % 3 == 1) assert(map.get(*s) == i + 1000);
+        else assert(map.get(*s) == i);
+        delete s;
+    }
+    assert(map.size() == n - (n + 2) / 3);
+    // Clearing a growing map empties both of its arrays, and it can be filled again
+    while (!map.growing()) {
+        String* s = buf.c("g").c(n++).get();
+        map.put(*s, n);
+        delete s;
+    }
+    map.clear();
+    assert(map.size() == 0 && !map.growing());
+    for (size_t i = 0; i < map.capacity(); i++) assert(map.key_at(i) == nullptr);
+    String g("g1");
+    assert(!map.contains(g));
+    map.put(g, 1);
+    assert(map.get(g) == 1 && map.size() == 1);
+    printf("HashMap growing tests passed.\n");
+}
+
+/** Tests counting in place, merging, and counting the rows of a key and count DataFrame. */
+void test_count_maps() {
+    CountMap counts;
+    String a("a");
+    String b("b");
+    assert(counts.get(a) == 0);
+    assert(counts.increment(a) == 1);
+    assert(counts.increment(a, 4) == 5);
+    counts.increment(b);
+    assert(counts.size() == 2);
+
+    CountMap other;
+    other.increment(b, 10);
+    String c("c");
+    other.increment(c);
+    counts.merge(other);
+    assert(counts.size() == 3);
+    assert(counts.get(a) == 5 && counts.get(b) == 11 && counts.get(c) == 1);
+
+    // Counts are 64 bits wide
+    int64_t big = (int64_t)1 << 40;
+    counts.increment(a, big);
+    assert(counts.get(a) == big + 5);
+
+    IntCountMap ints;
+    size_t n = 5000;
+    for (size_t r = 0; r < 3; r++) {
+        for (int i = 0; i < (int)n; i++) ints.increment(i - 100);
+    }
+    assert(ints.size() == n);
+    assert(ints.get(-100) == 3 && ints.get(4899) == 3 && ints.get(4900) == 0);
+    IntCountMap more;
+    more.increment(-100, 2);
+    more.increment(9999);
+    ints.merge(more);
+    assert(ints.size() == n + 1 && ints.get(-100) == 5 && ints.get(9999) == 1);
+
+    // A weighted CountRower adds the counts of rows such as those of DataFrame::fromCounts()
+    Schema scm("SI");
+    Row row(scm);
+    CountMap merged;
+    CountRower<CountMap> add(merged, true);
+    row.set(0, new String("a"));
+    row.set(1, 3);
+    add.accept(row);
+    add.accept(row);
+    assert(merged.get(a) == 6 && merged.size() == 1);
+    CountRower<CountMap> count(merged);
+    count.accept(row);
+    assert(merged.get(a) == 7);
+
+    // A CountWriter writes every key once with its count
+    CountWriter<IntCountMap> w(more);
+    Schema int_scm("II");
+    Row out(int_scm);
+    int64_t total = 0;
+    size_t rows = 0;
+    while (!w.done()) {
+        w.visit(out);
+        assert(out.get_int(1) == more.get(out.get_int(0)));
+        total += out.get_int(1);
+        rows++;
+    }
+    assert(rows == 2 && total == 3);
+    printf("CountMap tests passed.\n");
+}
+
 int main() {
     // A map with an initial capacity of one.
     Map* map = new Map(1);
@@ -41,5 +215,8 @@ int main() {
     delete map;
     delete k; delete k2; delete k3; delete k4;
     printf("Map tests passed.\n");
+    test_hashmap();
+    test_hashmap_growing();
+    test_count_maps();
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 // //lang::CwC
 
 #include <assert.h>
+#include <limits.h>
+#include <float.h>
 #include "../src/deserial.h"
 #include "../src/dataframe.h"
 
@@ -108,7 +110,7 @@ void test_string_vector_serialization() {
 
 void test_message_serialization(KVStore* kv) {
     /* Ack construction */
-    Ack* ack = new Ack();
+    Ack* ack = new Ack(7);
 
     /* Ack serialization */
     const char* serialized_ack = ack->serialize();
@@ -118,6 +120,7 @@ void test_message_serialization(KVStore* kv) {
     Ack* deserialized_ack = ack_ds.deserialize_message()->as_ack();
     assert(deserialized_ack != nullptr);
     assert(deserialized_ack->equals(ack)); // Testing acknowledge equality.
+    assert(deserialized_ack->id() == 7);
 
     delete ack;
     delete[] serialized_ack;
@@ -164,7 +167,7 @@ void test_message_serialization(KVStore* kv) {
     Key* key1 = new Key("foo",0);
     DataFrame* df = df_(kv, key1);
     const char* serial_df = df->serialize();
-    Put* put = new Put(key1, serial_df);
+    Put* put = new Put(key1, serial_df, 7);
 
     /* Put serialization */
     const char* serialized_put = put->serialize();
@@ -174,6 +177,7 @@ void test_message_serialization(KVStore* kv) {
     Put* deserialized_put = put_deserializer.deserialize_message()->as_put();
     assert(deserialized_put != nullptr);
     assert(deserialized_put->equals(put));
+    assert(deserialized_put->id() == 7);
 
     delete[] serial_df;
     delete put;
@@ -184,7 +188,7 @@ void test_message_serialization(KVStore* kv) {
 
     /* Get construction */
     Key* key2 = new Key("foo", 0);
-    Get* get = new Get(key2);
+    Get* get = new Get(key2, 8);
 
     /* Get serialization */
     const char* serialized_get = get->serialize();
@@ -194,6 +198,7 @@ void test_message_serialization(KVStore* kv) {
     Get* deserialized_get = get_deserializer.deserialize_message()->as_get();
     assert(deserialized_get != nullptr);
     assert(deserialized_get->equals(get));
+    assert(deserialized_get->id() == 8);
 
     delete key2;
     delete get;
@@ -203,7 +208,7 @@ void test_message_serialization(KVStore* kv) {
 
     /* WaitAndGet construction */
     Key* key3 = new Key("foo", 0);
-    WaitAndGet* w_get = new WaitAndGet(key3);
+    WaitAndGet* w_get = new WaitAndGet(key3, 9);
 
     /* WaitAndGet serialization */
     const char* serialized_w_get = w_get->serialize();
@@ -213,6 +218,7 @@ void test_message_serialization(KVStore* kv) {
     WaitAndGet* deserialized_w_get = w_get_deserializer.deserialize_message()->as_wait_and_get();
     assert(deserialized_w_get != nullptr);
     assert(deserialized_w_get->equals(w_get));
+    assert(deserialized_w_get->id() == 9);
 
     delete key3;
     delete w_get;
@@ -222,7 +228,7 @@ void test_message_serialization(KVStore* kv) {
 
     /* Reply construction */
     const char* serial_df2 = df->serialize();
-    Reply* rep = new Reply(serial_df2, MsgKind::Get);
+    Reply* rep = new Reply(serial_df2, MsgKind::Get, 8);
 
     /* Reply serialization */
     const char* serialized_reply = rep->serialize();
@@ -232,6 +238,7 @@ void test_message_serialization(KVStore* kv) {
     Reply* deserialized_reply = reply_deserializer.deserialize_message()->as_reply();
     assert(deserialized_reply != nullptr);
     assert(deserialized_reply->equals(rep));
+    assert(deserialized_reply->id() == 8);
 
     delete key1;
     delete df;
@@ -335,6 +342,13 @@ void test_key_serialization() {
     Key* deserialized_key = key_deserializer.deserialize_key();
     assert(deserialized_key != nullptr);
     assert(deserialized_key->equals(k));
+    /* Equal keys hash alike, and keys that differ only by node do not */
+    assert(deserialized_key->hash() == k->hash());
+    Key other_node("Key 1", 1);
+    assert(other_node.hash() != k->hash());
+    Key* copy = k->clone();
+    assert(copy->hash_ == k->hash());
+    delete copy;
 
     delete k;
     delete[] serialized_key;
@@ -342,6 +356,489 @@ void test_key_serialization() {
     
 }
 
+void test_multi_message_serialization() {
+    /* MultiPut construction, the second value contains a newline and a brace */
+    Key* keys[2] = { new Key("a", 1), new Key("b", 1) };
+    const char* vals[2] = { "{1}first", "sec\nond}" };
+    MultiPut* mp = new MultiPut(2, keys, vals, 11);
+
+    /* MultiPut serialization and deserialization */
+    const char* serialized_mp = mp->serialize();
+    Deserializer mp_ds(serialized_mp);
+    MultiPut* deserialized_mp = mp_ds.deserialize_message()->as_multi_put();
+    assert(deserialized_mp != nullptr);
+    assert(deserialized_mp->equals(mp));
+    assert(deserialized_mp->id() == 11);
+
+    /* MultiGet serialization and deserialization */
+    MultiGet* mg = new MultiGet(2, keys, 12);
+    const char* serialized_mg = mg->serialize();
+    Deserializer mg_ds(serialized_mg);
+    MultiGet* deserialized_mg = mg_ds.deserialize_message()->as_multi_get();
+    assert(deserialized_mg != nullptr);
+    assert(deserialized_mg->equals(mg));
+
+    /* MultiReply serialization and deserialization */
+    MultiReply* mr = new MultiReply(2, vals, 12);
+    const char* serialized_mr = mr->serialize();
+    Deserializer mr_ds(serialized_mr);
+    MultiReply* deserialized_mr = mr_ds.deserialize_message()->as_multi_reply();
+    assert(deserialized_mr != nullptr);
+    assert(deserialized_mr->equals(mr));
+    assert(deserialized_mr->as_reply() == nullptr);
+
+    for (size_t i = 0; i < 2; i++) {
+        delete deserialized_mp->get_key(i);
+        delete[] deserialized_mp->get_value(i);
+        delete deserialized_mg->get_key(i);
+        delete[] deserialized_mr->get_value(i);
+        delete keys[i];
+    }
+    delete[] deserialized_mp->keys_; delete[] deserialized_mp->vals_;
+    delete[] deserialized_mp->lens_;
+    delete[] deserialized_mg->keys_;
+    delete[] deserialized_mr->vals_; delete[] deserialized_mr->lens_;
+    delete deserialized_mp; delete deserialized_mg; delete deserialized_mr;
+    delete mp; delete mg; delete mr;
+    delete[] serialized_mp; delete[] serialized_mg; delete[] serialized_mr;
+}
+
+void test_number_deserialization() {
+    /* Numbers are parsed where they are in the stream, whatever follows them */
+    const char* stream = "{2147483647}{-2147483648}{-7}{0}{18446744073709551615}{1}{0}"
+        "{-0.5000000}{340282346638528859811704183484516925440.0000000}{0.1000000}tail";
+    Deserializer ds(stream);
+    assert(ds.deserialize_int() == INT_MAX);
+    assert(ds.deserialize_int() == INT_MIN);
+    assert(ds.deserialize_int() == -7);
+    assert(ds.deserialize_size_t() == 0);
+    assert(ds.deserialize_size_t() == SIZE_MAX);
+    assert(ds.deserialize_bool());
+    assert(!ds.deserialize_bool());
+    assert(ds.deserialize_float() == -0.5f);
+    assert(ds.deserialize_float() == FLT_MAX);
+    assert(ds.deserialize_float() == 0.1f);
+    assert(strcmp(ds.stream_ + ds.i_, "tail") == 0);
+
+    /* Every value that is serialized reads back the same */
+    int ints[] = { 0, 1, -1, 42, -42, INT_MAX, INT_MIN };
+    for (int i : ints) {
+        char* serial = Serializer::serialize_int(i);
+        Deserializer d(serial);
+        assert(d.deserialize_int() == i);
+        delete[] serial;
+    }
+}
+
+/* Deserializes the message in the given payload, which may hold null bytes. */
+Message* deserialize_payload_(Payload& p) {
+    char* flat = p.c_str();
+    Deserializer ds(flat, p.size());
+    Message* res = ds.deserialize_message();
+    delete[] flat;
+    return res;
+}
+
+void test_binary_value_serialization() {
+    /* Values with null bytes survive every message that carries values, given their lengths */
+    const char bin1[] = { 'a', '\0', '\n', 'b', '\0' };
+    const char bin2[] = { '\0', '\0', '}', '{' };
+    Key* keys[2] = { new Key("a", 1), new Key("b", 1) };
+    const char* vals[2] = { bin1, bin2 };
+    size_t lens[2] = { sizeof(bin1), sizeof(bin2) };
+
+    Put put(keys[0], bin1, sizeof(bin1), 3);
+    Payload put_p;
+    put.serialize(put_p);
+    Put* d_put = deserialize_payload_(put_p)->as_put();
+    assert(d_put != nullptr && d_put->equals(&put) && d_put->get_size() == sizeof(bin1));
+    assert(d_put->get_value()[sizeof(bin1)] == '\0');
+
+    Reply rep(bin2, sizeof(bin2), MsgKind::Get, 4);
+    Payload rep_p;
+    rep.serialize(rep_p);
+    Reply* d_rep = deserialize_payload_(rep_p)->as_reply();
+    assert(d_rep != nullptr && d_rep->equals(&rep) && d_rep->get_size() == sizeof(bin2));
+
+    MultiPut mp(2, keys, vals, 5, lens);
+    Payload mp_p;
+    mp.serialize(mp_p);
+    MultiPut* d_mp = deserialize_payload_(mp_p)->as_multi_put();
+    assert(d_mp != nullptr && d_mp->equals(&mp));
+
+    MultiReply mr(2, vals, 6, lens);
+    Payload mr_p;
+    mr.serialize(mr_p);
+    MultiReply* d_mr = deserialize_payload_(mr_p)->as_multi_reply();
+    assert(d_mr != nullptr && d_mr->equals(&mr));
+    assert(d_mr->get_size(1) == sizeof(bin2) && memcmp(d_mr->get_value(1), bin2, 4) == 0);
+
+    delete d_put->get_key(); delete[] d_put->get_value(); delete d_put;
+    delete[] d_rep->get_value(); delete d_rep;
+    for (size_t i = 0; i < 2; i++) {
+        delete d_mp->get_key(i);
+        delete[] d_mp->get_value(i);
+        delete[] d_mr->get_value(i);
+        delete keys[i];
+    }
+    delete[] d_mp->keys_; delete[] d_mp->vals_; delete[] d_mp->lens_; delete d_mp;
+    delete[] d_mr->vals_; delete[] d_mr->lens_; delete d_mr;
+}
+
+/* Returns the chunk serialized in the binary format and deserialized again. */
+Chunk* binary_round_trip_(Chunk* c, StringPool* pool = nullptr, bool encode = true) {
+    size_t len;
+    const char* serial = c->serialize_binary(len, encode);
+    assert(serial[0] == CHUNK_BINARY_TAG && serial[len] == '\0');
+    Deserializer ds(serial, len);
+    if (pool != nullptr) ds.intern_into(pool);
+    Chunk* res = ds.deserialize_chunk();
+    assert(ds.i_ == len);
+    delete[] serial;
+    return res;
+}
+
+/* Asserts that the two chunks have the same index and equal fields. */
+void assert_same_chunk_(Chunk* a, Chunk* b) {
+    assert(a->idx() == b->idx() && a->size() == b->size());
+    for (size_t i = 0; i < a->size(); i++) assert(a->get(i)->equals(b->get(i)));
+}
+
+void test_chunk_serialization() {
+    float floats[] = { 0.1f, -0.0f, 1e-40f, 3.4028235e38f, -123456.789f, 1.0f / 3 };
+    Chunk ints(3), fs(4), bools(5), strs(6), missing(7), empty(8);
+    for (size_t i = 0; i < 70; i++) {
+        DataType* i_dt = new DataType();
+        DataType* f_dt = new DataType();
+        DataType* b_dt = new DataType();
+        DataType* s_dt = new DataType();
+        // Every fifth field is missing
+        if (i % 5 != 4) {
+            i_dt->set_int(i % 2 == 0 ? (int)(i * 1000003) : -(int)i);
+            f_dt->set_float(floats[i % 6] * (i + 1));
+            b_dt->set_bool(i % 3 == 0);
+            StrBuff buf;
+            s_dt->set_string(i % 7 == 0 ? new String("") : buf.c("str-").c(i).get());
+        }
+        ints.append(i_dt);
+        fs.append(f_dt);
+        bools.append(b_dt);
+        strs.append(s_dt);
+        missing.append(new DataType());
+    }
+    Chunk* chunks[] = { &ints, &fs, &bools, &strs, &missing, &empty };
+    for (Chunk* c : chunks) {
+        Chunk* res = binary_round_trip_(c);
+        assert_same_chunk_(c, res);
+        delete res;
+    }
+    // Floats come back bit for bit, where the text format rounds them to 7 decimals
+    Chunk* res = binary_round_trip_(&fs);
+    for (size_t i = 0; i < fs.size(); i++) {
+        if (fs.get(i)->get_type() == 'U') continue;
+        float a = fs.get(i)->get_float(), b = res->get(i)->get_float();
+        assert(memcmp(&a, &b, sizeof(float)) == 0);
+    }
+    delete res;
+    // The missing fields stay missing
+    res = binary_round_trip_(&ints);
+    assert(res->get(4)->get_type() == 'U' && res->get(5)->get_type() == 'I');
+    delete res;
+    // Strings can be interned while they are read
+    StringPool pool;
+    res = binary_round_trip_(&strs, &pool);
+    assert_same_chunk_(&strs, res);
+    assert(res->get(1)->is_interned());
+    assert(res->get(1)->get_string() == pool.intern(*strs.get(1)->get_string()));
+    delete res;
+    // Chunks in the text format can still be read
+    const char* text = strs.serialize();
+    Deserializer ds(text);
+    res = ds.deserialize_chunk();
+    assert_same_chunk_(&strs, res);
+    delete res;
+    delete[] text;
+}
+
+/* Returns a chunk of CHUNK_SIZE ints made by the given function of their index, with every
+ * hundredth field missing. */
+template <class F>
+Chunk* int_chunk_(F f) {
+    Chunk* c = new Chunk(0);
+    for (size_t i = 0; i < CHUNK_SIZE; i++) {
+        DataType* dt = new DataType();
+        if (i % 100 != 99) dt->set_int(f(i));
+        c->append(dt);
+    }
+    return c;
+}
+
+/* Serializes the chunk in the binary format, checks that it reads back the same with and without
+ * a StringPool and that it is no larger than raw, and returns its codec and length. */
+ChunkCodec check_codec_(Chunk* c, size_t& len) {
+    size_t raw_len;
+    const char* raw = c->serialize_binary(raw_len, false);
+    assert((ChunkCodec)raw[2] == ChunkCodec::Raw);
+    const char* serial = c->serialize_binary(len);
+    assert(len <= raw_len);
+    StringPool pool;
+    StringPool* pools[] = { nullptr, &pool };
+    for (StringPool* p : pools) {
+        Chunk* res = binary_round_trip_(c, p);
+        assert_same_chunk_(c, res);
+        delete res;
+        res = binary_round_trip_(c, p, false);
+        assert_same_chunk_(c, res);
+        delete res;
+    }
+    ChunkCodec res = (ChunkCodec)serial[2];
+    delete[] raw;
+    delete[] serial;
+    return res;
+}
+
+void test_chunk_codecs() {
+    size_t len;
+    /* Sorted ids take a byte each as deltas */
+    Chunk* c = int_chunk_([](size_t i) { return (int)i + 1000000; });
+    assert(check_codec_(c, len) == ChunkCodec::DeltaVarint);
+    assert(len <= CHUNK_HEADER_SIZE + Chunk::bitmap_bytes_(CHUNK_SIZE) + CHUNK_SIZE + 8);
+    delete c;
+    /* Unsorted ints in a narrow range, including negative ones, are packed into a few bits */
+    c = int_chunk_([](size_t i) { return (int)(i * 7919 % 1000) - 500; });
+    assert(check_codec_(c, len) == ChunkCodec::FrameOfRef);
+    delete c;
+    /* Equal ints take no bits at all */
+    c = int_chunk_([](size_t i) { return 7; });
+    assert(check_codec_(c, len) == ChunkCodec::FrameOfRef);
+    assert(len == CHUNK_HEADER_SIZE + Chunk::bitmap_bytes_(CHUNK_SIZE) + 8);
+    delete c;
+    /* Ints that jump across the whole range stay raw */
+    c = int_chunk_([](size_t i) { return i % 2 == 0 ? INT_MIN + (int)i : INT_MAX - (int)i; });
+    assert(check_codec_(c, len) == ChunkCodec::Raw);
+    delete c;
+
+    /* A few repeated words are written once each, missing fields included */
+    const char* words[] = { "the", "quick", "", "fox" };
+    Chunk* few = new Chunk(1);
+    Chunk* many = new Chunk(2);
+    StrBuff buf;
+    for (size_t i = 0; i < CHUNK_SIZE; i++) {
+        DataType* dt = new DataType();
+        if (i % 50 != 49) dt->set_string(new String(words[i * 7 % 4]));
+        few->append(dt);
+        dt = new DataType();
+        dt->set_string(buf.c("word-").c(i).get());
+        many->append(dt);
+    }
+    assert(check_codec_(few, len) == ChunkCodec::Dictionary);
+    assert(len < CHUNK_SIZE / 2);
+    /* Strings that are all different stay raw */
+    assert(check_codec_(many, len) == ChunkCodec::Raw);
+    /* Each word of a dictionary is interned once */
+    StringPool pool;
+    Chunk* res = binary_round_trip_(few, &pool);
+    assert(res->get(0)->get_string() == res->get(4)->get_string());
+    assert(pool.size() == 4);
+    delete res;
+    delete few;
+    delete many;
+}
+
+void test_frame_serialization() {
+    /* A Put whose value contains newlines and is followed by another frame's bytes */
+    Key* k = new Key("frame", 1);
+    Put* put = new Put(k, "line 1\nline 2\n", 42);
+    const char* serialized_put = put->serialize();
+    size_t len = strlen(serialized_put);
+
+    /* Frame header encoding */
+    char header[FRAME_HEADER_SIZE];
+    FrameHeader(len, (uint32_t)MsgKind::Put, 1ul << 40 | 42).encode(header);
+    FrameHeader h;
+    h.decode(header);
+    assert(h.len_ == len);
+    assert(h.kind_ == (uint32_t)MsgKind::Put);
+    assert(h.id_ == (1ul << 40 | 42));
+
+    /* Deserializing only the frame's payload */
+    StrBuff buff;
+    buff.c(serialized_put);
+    buff.c(serialized_put);
+    char* two_frames = buff.c_str();
+    Deserializer ds(two_frames, len);
+    Put* deserialized_put = ds.deserialize_message()->as_put();
+    assert(deserialized_put != nullptr);
+    assert(deserialized_put->equals(put));
+
+    delete put;
+    delete k;
+    delete[] serialized_put;
+    delete[] two_frames;
+    delete deserialized_put->get_key();
+    delete[] deserialized_put->get_value();
+    delete deserialized_put;
+}
+
+/* Returns everything written to the given file, which is rewound first. The caller owns it. */
+char* read_file_(FILE* f, size_t len) {
+    rewind(f);
+    char* res = new char[len + 1];
+    assert(fread(res, 1, len, f) == len);
+    res[len] = '\0';
+    return res;
+}
+
+void test_sinks() {
+    /* Every sink gets the same bytes as serialize() returns */
+    Key* k = new Key("sink", 2);
+    const char big[] = "a value that is only lent to the sink";
+    Put put(k, big, 9);
+    const char* serial = put.serialize();
+    size_t len = strlen(serial);
+
+    StrBuff buff;
+    put.serialize(buff);
+    char* from_buff = buff.c_str();
+    assert(strcmp(serial, from_buff) == 0);
+
+    /* The pieces around the value are copied into one range, the value is sent where it is */
+    Payload p;
+    put.serialize(p);
+    assert(p.size() == len && p.count() == 3);
+    assert(p.part(1).iov_base == big && p.part(1).iov_len == strlen(big));
+    char* from_payload = p.c_str();
+    assert(strcmp(serial, from_payload) == 0);
+
+    FILE* f = tmpfile();
+    assert(f != nullptr);
+    FileSink fs(f);
+    put.serialize(fs);
+    assert(fs.size() == len);
+    char* from_file = read_file_(f, len);
+    assert(strcmp(serial, from_file) == 0);
+    fclose(f);
+
+    /* Numbers written to a sink read back exactly */
+    StrBuff nums;
+    Serializer::write_int(nums, INT_MIN);
+    Serializer::write_size_t(nums, SIZE_MAX);
+    Serializer::write_float(nums, -1.5f);
+    Serializer::write_bool(nums, true);
+    char* serial_nums = nums.c_str();
+    assert(strcmp(serial_nums, "{-2147483648}{18446744073709551615}{-1.5000000}{1}") == 0);
+
+    delete k;
+    delete[] serial; delete[] from_buff; delete[] from_payload; delete[] from_file;
+    delete[] serial_nums;
+}
+
+void test_interned_string_deserialization() {
+    StringPool pool;
+    String* apple = pool.intern("apple", 5);
+    /* Interning the same contents again gives back the same String */
+    assert(pool.intern("apple pie", 5) == apple);
+    String pear("pear");
+    String* interned_pear = pool.intern(pear);
+    assert(interned_pear != &pear && interned_pear->equals(&pear));
+    assert(pool.size() == 2 && pool.id(apple) == 0 && pool.get(1) == interned_pear);
+
+    /* Deserialized string fields are interned when a pool is given */
+    DataType dt;
+    dt.set_string(new String("pear"));
+    const char* serial = dt.serialize();
+    Deserializer ds(serial);
+    ds.intern_into(&pool);
+    DataType* d1 = ds.deserialize_datatype();
+    Deserializer ds2(serial);
+    ds2.intern_into(&pool);
+    DataType* d2 = ds2.deserialize_datatype();
+    assert(d1->is_interned() && d1->get_string() == interned_pear);
+    assert(d2->get_string() == interned_pear && d1->equals(d2) && d1->equals(&dt));
+    assert(pool.size() == 2);
+
+    /* Copies share the interned String, and taking it out gives a String of one's own */
+    DataType* copy = d1->clone();
+    assert(copy->get_string() == interned_pear);
+    String* taken = copy->take_string();
+    assert(taken != interned_pear && taken->equals(interned_pear));
+
+    delete taken;
+    delete copy;
+    delete d1;
+    delete d2;
+    delete[] serial;
+}
+
+/* Tests moving Strings and Keys, and looking keys up through views */
+void test_key_moves() {
+    String a("moved");
+    size_t h = a.hash();
+    char* chars = a.c_str();
+    String b(std::move(a));
+    assert(b.c_str() == chars && b.size() == 5 && b.hash() == h);
+    assert(a.c_str() == nullptr && a.size() == 0);
+    String c("other");
+    c = std::move(b);
+    assert(c.c_str() == chars && c.hash() == h);
+
+    Key k(String("moved"), 2);
+    assert(k.get_keystring()->equals(&c) && k.get_home_node() == 2);
+    Key* copy = k.clone();
+    Key m(std::move(*copy));
+    assert(m.equals(&k) && m.hash() == k.hash());
+    delete copy;
+
+    /* A view equals the key it looks like, and can be used to find it in a map */
+    KeyView v("moved", 5, 2);
+    assert(v.equals(&k) && v.hash() == k.hash());
+    HashMap<String, size_t> map;
+    map.put(*k.get_keystring(), 7);
+    StrView sv("moved!", 5);
+    assert(map.get(sv) == 7);
+    assert(map.get(*v.get_keystring()) == 7);
+    Key* owned = v.clone();
+    assert(owned->equals(&k) && owned->get_keystring()->c_str() != v.get_keystring()->c_str());
+    delete owned;
+
+    /* KeyBuff builds keys off of the original one, starting over each time */
+    Key base("base", 0);
+    KeyBuff kbuf(&base);
+    Key* k1 = kbuf.c("-").c((size_t)1).get(1);
+    KeyView k3 = kbuf.c("-").c((size_t)3).view(1);
+    assert(strcmp(k1->get_keystring()->c_str(), "base-1") == 0 && k1->get_home_node() == 1);
+    assert(strcmp(k3.get_keystring()->c_str(), "base-3") == 0 && k3.get_home_node() == 1);
+    Key expected("base-3", 1);
+    assert(k3.equals(&expected) && k3.hash() == expected.hash());
+    delete k1;
+}
+
+void test_arena() {
+    Arena a;
+    Arena::Mark start = a.mark();
+    char* x = a.alloc(3);
+    char* y = a.alloc(8);
+    /* Allocations are aligned and do not overlap */
+    assert((size_t)y % 8 == 0 && y >= x + 3);
+    /* Rewinding gives the memory back to be handed out again */
+    a.rewind(start);
+    assert(a.alloc(3) == x);
+    /* Allocations larger than a block get a block of their own */
+    char* big = a.alloc(ARENA_BLOCK_SIZE * 2);
+    memset(big, 'b', ARENA_BLOCK_SIZE * 2);
+    assert(a.capacity() >= ARENA_BLOCK_SIZE * 3);
+    a.rewind(start);
+
+    /* Everything the scope allocated was given back */
+    Arena::Mark m = Arena::local().mark();
+    {
+        ArenaScope scope;
+        scope.alloc(100);
+    }
+    Arena::Mark after = Arena::local().mark();
+    assert(m.block_ == after.block_ && m.used_ == after.used_);
+}
+
 int main() {
     KVStore* kv = new KVStore(0, 1);
 
@@ -351,6 +848,16 @@ int main() {
     test_key_serialization();
     test_dataframe_serialization(kv);
     test_message_serialization(kv);
+    test_multi_message_serialization();
+    test_binary_value_serialization();
+    test_number_deserialization();
+    test_chunk_serialization();
+    test_chunk_codecs();
+    test_frame_serialization();
+    test_sinks();
+    test_interned_string_deserialization();
+    test_key_moves();
+    test_arena();
     printf("All serialization tests passed!\n");
     
     kv->shutdown();
@@ -0,0 +1,77 @@
+#include "../src/vector.h"
+#include <assert.h>
+#include <utility>
+
+/** Tests appending to, reading from and setting a TypedVector as it grows past its inline space. */
+void test_append_get_set() {
+    TypedVector<double> v;
+    assert(v.size() == 0);
+    for (size_t i = 0; i < 1000; i++) v.append(i * 0.5);
+    assert(v.size() == 1000);
+    for (size_t i = 0; i < 1000; i++) assert(v.get(i) == i * 0.5);
+    v.set(-1.0, 10);
+    v.set(2.0, 1000);
+    assert(v.get(10) == -1.0 && v.get(1000) == 2.0 && v.size() == 1001);
+    v.clear();
+    assert(v.size() == 0);
+    printf("TypedVector append/get/set test passed.\n");
+}
+
+/** Tests the bulk operations and reserve. */
+void test_bulk() {
+    size_t vals[100];
+    for (size_t i = 0; i < 100; i++) vals[i] = i * i;
+    TypedVector<size_t> v;
+    v.append(7);
+    v.append_n(vals, 100);
+    assert(v.size() == 101 && v.get(0) == 7 && v.get(100) == 99 * 99);
+    size_t out[10];
+    v.copy_out(51, 10, out);
+    for (size_t i = 0; i < 10; i++) assert(out[i] == (50 + i) * (50 + i));
+
+    TypedVector<bool> b;
+    b.reserve(500);
+    bool* before = b.data();
+    for (size_t i = 0; i < 500; i++) b.append(i % 3 == 0);
+    // Nothing was reallocated after reserve()
+    assert(b.data() == before && b.size() == 500 && b.get(3) && !b.get(4));
+    printf("TypedVector bulk test passed.\n");
+}
+
+/** Tests that moving a TypedVector hands over its elements, whether inline or on the heap. */
+void test_move() {
+    TypedVector<int> small;
+    small.append(1);
+    small.append(2);
+    TypedVector<int> small2(std::move(small));
+    assert(small.size() == 0 && small2.size() == 2 && small2.get(1) == 2);
+
+    TypedVector<int> big;
+    for (int i = 0; i < 100; i++) big.append(i);
+    int* arr = big.data();
+    TypedVector<int> big2;
+    big2.append(5);
+    big2 = std::move(big);
+    assert(big.size() == 0 && big2.size() == 100 && big2.data() == arr && big2.get(99) == 99);
+    printf("TypedVector move test passed.\n");
+}
+
+/** Tests IntVector, which is built on TypedVector. */
+void test_int_vector() {
+    IntVector a;
+    IntVector b;
+    for (int i = 0; i < 20; i++) a.append(i);
+    b.append_all(&a);
+    assert(a.equals(&b) && b.size() == 20);
+    b.set(100, 3);
+    assert(!a.equals(&b));
+    printf("IntVector test passed.\n");
+}
+
+int main() {
+    test_append_get_set();
+    test_bulk();
+    test_move();
+    test_int_vector();
+    return 0;
+}
@@ -20,8 +20,7 @@ public:
       ++i_;
     }
     buf_[i_] = 0;
-    String* word = new String(buf_ + wStart, i_ - wStart);
-    r.set(0, word);
+    r.set_interned(0, strings_.intern(buf_ + wStart, i_ - wStart));
     ++i_;
     skipWhitespace_();
   }
@@ -31,8 +30,9 @@ public:
       all been read.     */
   bool done() override { return (i_ >= end_) && feof(file_);  }
 
-  /** Creates the reader and opens the file for reading.  */
-  FileReader(char* file) {
+  /** Creates the reader and opens the file for reading. Words are interned
+      into the given pool.  */
+  FileReader(char* file, StringPool& strings) : strings_(strings) {
     file_ = fopen(file, "r");
     if (file_ == nullptr) std::cout << "Cannot open file " << file;
     buf_ = new char[BUFSIZE + 1]; //  null terminator
@@ -76,6 +76,7 @@ public:
     }
   }
 
+  StringPool& strings_;
   char * buf_;
   size_t end_ = 0;
   size_t i_ = 0;
@@ -83,70 +84,6 @@ public:
 };
  
  
-/****************************************************************************/
-class Adder : public Rower {
-public:
-  SIMap& map_;  // String to Num map;  Num holds an int
- 
-  Adder(SIMap& map) : map_(map)  {}
- 
-  bool accept(Row& r) override {
-    String* word = r.get_string(0);
-    assert(word != nullptr);
-    Num* num = map_.contains(*word) ? new Num(map_.get(*word)->v) : new Num();
-    num->v++;
-    map_.put(*word, num);
-    return false;
-  }
-};
- 
-/***************************************************************************/
-class Summer : public Writer {
-public:
-  SIMap& map_;
-  size_t i = 0;
-  size_t j = 0;
-  size_t seen = 0;
- 
-  Summer(SIMap& map) : map_(map) {}
- 
-  void next() {
-    if (i == map_.capacity_ ) return;
-    if ( j < map_.items_[i].keys_.size() ) {
-      j++;
-    } else {
-      ++i;
-      j = 0;
-      while( i < map_.capacity_ && map_.items_[i].keys_.size() == 0 )  i++;
-    }
-  }
- 
-  String* k() {
-    if (i==map_.capacity_ || j == map_.items_[i].keys_.size()) 
-      return nullptr;
-    return (String*) (map_.items_[i].keys_.get(j));
-  }
- 
-  size_t v() {
-    if (i == map_.capacity_ || j == map_.items_[i].keys_.size()) {
-      assert(false); return 0;
-    }
-    return ((Num*)(map_.items_[i].vals_.get(j)))->v;
-  }
- 
-  void visit(Row& r) {
-    if (!k()) next();
-    String* key = k()->clone();
-    size_t value = v();
-    r.set(0, key);
-    r.set(1, (int) value);
-    ++seen;
-    next();
-  }
- 
-  bool done() { return seen == map_.size(); }
-};
- 
 /****************************************************************************
  * Calculate a word count for given file:
  *   1) read the data (single node)
@@ -155,16 +92,18 @@ public:
  **********************************************************author: pmaj ****/
 class WordCount: public Application {
 public:
+  StringPool strings;  // every word seen on this node, shared by rows and chunks
   Key in;
   Key* map;
   KeyBuff kbuf;
-  SIMap all;
   char* file;
   size_t num_nodes;
+  bool show_memory;  // print every node's memory usage once the words are counted
  
-  WordCount(size_t idx, size_t num_nodes, char* file):
+  WordCount(size_t idx, size_t num_nodes, char* file, bool show_memory = false):
     Application(idx, num_nodes), in("data", 0), map(new Key("wc-map-",0)), kbuf(map), file(file),
-    num_nodes(num_nodes) { 
+    num_nodes(num_nodes), show_memory(show_memory) { 
+      kd_.get_kv()->intern_strings(&strings);
       run_();    
   }
 
@@ -173,7 +112,7 @@ public:
   /** The master nodes reads the input, then all of the nodes count. */
   void run_() override {
     if (this_node() == 0) {
-      FileReader fr(file);
+      FileReader fr(file, strings);
       delete DataFrame::fromVisitor(&in, &kd_, "S", fr);
     }
     local_count();
@@ -188,19 +127,27 @@ public:
         .pln(k->get_keystring()->c_str(), this_node());
       return k;
   }
+
+  /** Returns a view of the key for given node, for looking its counts up without allocating a
+   *  Key. The view is valid until the next key is built. */
+  KeyView key_view(size_t idx) {
+      KeyView k = kbuf.c(idx).view(0);
+      p("Node ", this_node()).p(this_node(), this_node()).p(": Created key ", this_node())
+        .pln(k.get_keystring()->c_str(), this_node());
+      return k;
+  }
  
   /** Compute word counts on the local node and build a data frame. */
   void local_count() {
     DataFrame* words = (kd_.wait_and_get(in));
     p("Node ", this_node()).p(this_node(), this_node())
       .pln(": starting local count...", this_node());
-    SIMap map;
-    Adder add(map);
+    CountMap counts;
+    CountRower<CountMap> add(counts);
     words->local_map(add);
     delete words;
-    Summer cnt(map);
     Key* local = mk_key(this_node());
-    delete DataFrame::fromVisitor(local, &kd_, "SI", cnt);
+    delete DataFrame::fromCounts(local, &kd_, counts, &strings);
     delete local;
   }
  
@@ -208,22 +155,22 @@ public:
   void reduce() {
     if (this_node() != 0) return;
     pln("Node 0: reducing counts...", this_node());
-    SIMap map;
-    Key* own = mk_key(0);
-    merge(kd_.get(*own), map);
+    CountMap counts;
+    KeyView own = key_view(0);
+    merge(kd_.get(own), counts);
     for (size_t i = 1; i < num_nodes; ++i) { // merge other nodes
-      Key* ok = mk_key(i);
-      merge(kd_.wait_and_get(*ok), map);
-      delete ok;
+      KeyView ok = key_view(i);
+      merge(kd_.wait_and_get(ok), counts);
     }
-    p("Different words: ", this_node()).pln(map.size(), this_node());
-    delete own;
+    p("Different words: ", this_node()).pln(counts.size(), this_node());
+    if (show_memory) print_memory();
     sleep(1);
     done();
   }
  
-  void merge(DataFrame* df, SIMap& m) {
-    Adder add(m);
+  /** Adds the counts of a node's data frame of words and counts to the given map. */
+  void merge(DataFrame* df, CountMap& m) {
+    CountRower<CountMap> add(m, true);
     df->map(add);
     delete df;
   }
@@ -234,9 +181,10 @@ int main(int argc, char** argv) {
   size_t node_idx;
   size_t num_nodes;
   char* filename;
+  bool show_memory = false;
   int c;
 
-  while ((c = getopt(argc, argv, "i:n:f:")) != -1) {
+  while ((c = getopt(argc, argv, "i:n:f:m")) != -1) {
     switch (c) {
       case 'i':
         node_idx = atoi(optarg);
@@ -247,11 +195,14 @@ int main(int argc, char** argv) {
       case 'f':
         filename = optarg;
         break;
+      case 'm':
+        show_memory = true;
+        break;
       default:
         fprintf(stderr, "Invalid command line args.");
         return 1;
     }
   }
 
-  WordCount(node_idx, num_nodes, filename);
+  WordCount(node_idx, num_nodes, filename, show_memory);
 }
\ No newline at end of file